@@ -0,0 +1,171 @@
+#include "processor.hpp"
+#include "workpool.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runs many simulations in one process:
+//
+//     batch <manifest> [--jobs <n>] [--out-dir <dir>]
+//
+// Each manifest line is "<inputfile> <engine> <cyclecount>", where engine is
+// forward, noforward or noforward_id; blank lines and lines starting with
+// '#' are skipped. Jobs run concurrently; with --out-dir each diagram is
+// written to <dir>/<input name>_<engine>_<line>_out.txt, where line is the
+// job's manifest line, so no two jobs share a file. A summary line per job
+// is printed in manifest order once all jobs are done.
+
+struct Job {
+    std::string inputFile;
+    std::string engine;
+    int cycles = 0;
+    int line = 0;  // in the manifest, naming the --out-dir file
+};
+
+struct JobResult {
+    int cycles = 0;
+    double seconds = 0;
+    std::string error;
+};
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <manifest> [--jobs <n>] [--out-dir <dir>]" << std::endl;
+}
+
+static bool isEngine(const std::string& name) {
+    return name == ForwardingPolicy::name || name == NoForwardingPolicy::name ||
+           name == NoForwardingDecodeBranchPolicy::name;
+}
+
+static std::vector<Job> readManifest(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open manifest: " + filename);
+    }
+
+    std::vector<Job> jobs;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+
+        std::stringstream ss(line);
+        Job job;
+        job.line = lineNumber;
+        std::string extra;
+        if (!(ss >> job.inputFile >> job.engine >> job.cycles) || (ss >> extra) ||
+            !isEngine(job.engine) || job.cycles <= 0) {
+            throw std::runtime_error("Invalid manifest line " + std::to_string(lineNumber) + ": \"" + line + "\"");
+        }
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+template <typename Policy>
+static int simulate(const Job& job, std::ostream* diagram) {
+    Processor<Policy> simulator;
+    std::ostream discard(nullptr);
+    simulator.setOutput(diagram ? *diagram : discard);
+    if (!diagram) simulator.discardHistory();
+    simulator.loadProgramFromFile(job.inputFile);
+    simulator.runSimulation(job.cycles);
+    if (diagram) simulator.displayPipeline();
+    return simulator.simulatedCycles();
+}
+
+static JobResult runJob(const Job& job, const std::string& outDir) {
+    JobResult result;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        std::ofstream file;
+        if (!outDir.empty()) {
+            std::string name = std::filesystem::path(job.inputFile).stem().string() + "_" + job.engine + "_" +
+                               std::to_string(job.line) + "_out.txt";
+            std::filesystem::path path = std::filesystem::path(outDir) / name;
+            file.open(path);
+            if (!file.is_open()) throw std::runtime_error("Could not open output file: " + path.string());
+        }
+        std::ostream* diagram = file.is_open() ? &file : nullptr;
+
+        if (job.engine == ForwardingPolicy::name) {
+            result.cycles = simulate<ForwardingPolicy>(job, diagram);
+        } else if (job.engine == NoForwardingPolicy::name) {
+            result.cycles = simulate<NoForwardingPolicy>(job, diagram);
+        } else {
+            result.cycles = simulate<NoForwardingDecodeBranchPolicy>(job, diagram);
+        }
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    std::string manifest;
+    std::string outDir;
+    unsigned threads = std::thread::hardware_concurrency();
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--jobs" || arg == "--out-dir") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (arg == "--out-dir") {
+                outDir = value;
+                continue;
+            }
+            try {
+                int count = std::stoi(value);
+                if (count <= 0) throw std::invalid_argument(value);
+                threads = static_cast<unsigned>(count);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid job count '" << value << "'." << std::endl;
+                return 1;
+            }
+        } else if (manifest.empty() && arg.rfind("--", 0) != 0) {
+            manifest = arg;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (manifest.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Job> jobs;
+    try {
+        jobs = readManifest(manifest);
+        if (!outDir.empty()) std::filesystem::create_directories(outDir);
+    } catch (const std::exception& e) {
+        std::cerr << "Runtime Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<JobResult> results(jobs.size());
+    auto start = std::chrono::steady_clock::now();
+    WorkStealingPool pool(threads);
+    pool.run(jobs.size(), [&](size_t index) {
+        results[index] = runJob(jobs[index], outDir);
+    });
+    double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int failed = 0;
+    std::cout << "input;engine;cycles;seconds;status" << std::endl;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const JobResult& result = results[i];
+        std::cout << jobs[i].inputFile << ";" << jobs[i].engine << ";" << result.cycles << ";"
+                  << result.seconds << ";" << (result.error.empty() ? "ok" : result.error) << std::endl;
+        if (!result.error.empty()) ++failed;
+    }
+    std::cerr << jobs.size() << " jobs, " << failed << " failed, " << total << " s wall" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,205 @@
+#include "cache.hpp"
+#include <sstream>
+#include <stdexcept>
+
+static bool isPowerOfTwo(uint32_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static bool parseNumber(const std::string& text, uint32_t& value) {
+    try {
+        size_t used = 0;
+        unsigned long number = std::stoul(text, &used, 0);
+        if (used + 1 == text.size() && (text[used] == 'k' || text[used] == 'K')) {
+            number *= 1024;
+        } else if (used != text.size()) {
+            return false;
+        }
+        value = static_cast<uint32_t>(number);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool parseCacheConfig(const std::string& spec, CacheConfig& config, std::string& error) {
+    config.enabled = true;
+    if (spec == "default") return true;
+
+    std::stringstream fields(spec);
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+        size_t equals = field.find('=');
+        std::string key = field.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : field.substr(equals + 1);
+        bool ok = true;
+        if (key == "size") ok = parseNumber(value, config.size);
+        else if (key == "ways") ok = parseNumber(value, config.ways);
+        else if (key == "line") ok = parseNumber(value, config.lineSize);
+        else if (key == "hit") ok = parseNumber(value, config.hitLatency);
+        else if (key == "miss") ok = parseNumber(value, config.missLatency);
+        else if (key == "repl" && (value == "lru" || value == "plru"))
+            config.replacement = value == "lru" ? Replacement::LRU : Replacement::PLRU;
+        else if (key == "write" && (value == "back" || value == "through")) config.writeBack = value == "back";
+        else if (key == "alloc" && (value == "yes" || value == "no")) config.writeAllocate = value == "yes";
+        else ok = false;
+        if (!ok) {
+            error = "Invalid cache setting '" + field + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+void CacheModel::configure(const CacheConfig& settings) {
+    config = settings;
+    if (!config.enabled) return;
+
+    if (!isPowerOfTwo(config.lineSize) || config.lineSize < 4) {
+        throw std::invalid_argument("Cache line size must be a power of two of at least 4 bytes");
+    }
+    if (config.ways == 0 || config.size % (config.ways * config.lineSize) != 0 ||
+        !isPowerOfTwo(config.size / (config.ways * config.lineSize))) {
+        throw std::invalid_argument("Cache size must be ways x line size x a power-of-two set count");
+    }
+    if (config.replacement == Replacement::PLRU && (!isPowerOfTwo(config.ways) || config.ways > 32)) {
+        throw std::invalid_argument("PLRU needs a power-of-two way count of at most 32");
+    }
+    if (config.hitLatency == 0 || config.missLatency < config.hitLatency) {
+        throw std::invalid_argument("Cache latencies must satisfy 1 <= hit <= miss");
+    }
+
+    sets = config.size / (config.ways * config.lineSize);
+    lineBits = 0;
+    while ((1u << lineBits) < config.lineSize) ++lineBits;
+    lines.assign(static_cast<size_t>(sets) * config.ways, Line());
+    plruBits.assign(sets, 0);
+    useClock = 0;
+}
+
+uint32_t CacheModel::victim(uint32_t set) const {
+    const Line* ways = &lines[static_cast<size_t>(set) * config.ways];
+    for (uint32_t way = 0; way < config.ways; ++way) {
+        if (!ways[way].valid) return way;
+    }
+    if (config.replacement == Replacement::PLRU) {
+        // Follow the tree bits from the root; 1 means the right half is older
+        uint32_t node = 1;
+        while (node < config.ways) node = node * 2 + ((plruBits[set] >> node) & 1);
+        return node - config.ways;
+    }
+    uint32_t oldest = 0;
+    for (uint32_t way = 1; way < config.ways; ++way) {
+        if (ways[way].lastUse < ways[oldest].lastUse) oldest = way;
+    }
+    return oldest;
+}
+
+void CacheModel::touch(uint32_t set, uint32_t way) {
+    if (config.replacement == Replacement::PLRU) {
+        // Point every node on the path at the other half
+        for (uint32_t node = way + config.ways; node > 1; node /= 2) {
+            uint32_t parent = node / 2;
+            if (node & 1) plruBits[set] &= ~(1u << parent);
+            else plruBits[set] |= 1u << parent;
+        }
+    } else {
+        lines[static_cast<size_t>(set) * config.ways + way].lastUse = ++useClock;
+    }
+}
+
+uint32_t CacheModel::access(uint32_t address, bool write, CacheStats& stats) {
+    ++(write ? stats.writes : stats.reads);
+    uint32_t block = address >> lineBits;
+    uint32_t set = block & (sets - 1);
+    uint32_t tag = block / sets;
+    Line* ways = &lines[static_cast<size_t>(set) * config.ways];
+
+    for (uint32_t way = 0; way < config.ways; ++way) {
+        if (ways[way].valid && ways[way].tag == tag) {
+            if (write && config.writeBack) ways[way].dirty = true;
+            touch(set, way);
+            stats.stallCycles += config.hitLatency - 1;
+            return config.hitLatency;
+        }
+    }
+
+    ++stats.misses;
+    if (write && !config.writeAllocate) {
+        stats.stallCycles += config.hitLatency - 1;
+        return config.hitLatency;  // straight to the write buffer
+    }
+    uint32_t way = victim(set);
+    if (ways[way].valid) {
+        if (ways[way].dirty) ++stats.writebacks;
+        evicted = true;
+        evictedAddress = (ways[way].tag * sets + set) << lineBits;
+    }
+    ways[way] = {true, write && config.writeBack, tag, 0};
+    touch(set, way);
+    stats.stallCycles += config.missLatency - 1;
+    return config.missLatency;
+}
+
+bool CacheModel::invalidate(uint32_t address) {
+    uint32_t block = address >> lineBits;
+    uint32_t set = block & (sets - 1);
+    uint32_t tag = block / sets;
+    Line* ways = &lines[static_cast<size_t>(set) * config.ways];
+    for (uint32_t way = 0; way < config.ways; ++way) {
+        if (ways[way].valid && ways[way].tag == tag) {
+            ways[way].valid = false;
+            ways[way].dirty = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CacheModel::takeEviction(uint32_t& address) {
+    if (!evicted) return false;
+    evicted = false;
+    address = evictedAddress;
+    return true;
+}
+
+void CacheModel::save(CheckpointWriter& out) const {
+    out.u8(config.enabled);
+    if (!config.enabled) return;
+    out.u32(config.size);
+    out.u32(config.ways);
+    out.u32(config.lineSize);
+    out.u8(static_cast<uint8_t>(config.replacement));
+    out.u64(useClock);
+    for (const Line& line : lines) {
+        out.u8(static_cast<uint8_t>(line.valid | (line.dirty << 1)));
+        out.u32(line.tag);
+        out.u64(line.lastUse);
+    }
+    for (uint32_t bits : plruBits) out.u32(bits);
+}
+
+void CacheModel::load(CheckpointReader& in) {
+    bool wasEnabled = in.u8() != 0;
+    if (wasEnabled != config.enabled) {
+        throw std::runtime_error("Checkpoint was taken with a different cache configuration");
+    }
+    if (!config.enabled) return;
+    uint32_t size = in.u32();
+    uint32_t ways = in.u32();
+    uint32_t lineSize = in.u32();
+    Replacement replacement = static_cast<Replacement>(in.u8());
+    if (size != config.size || ways != config.ways || lineSize != config.lineSize ||
+        replacement != config.replacement) {
+        throw std::runtime_error("Checkpoint was taken with a different cache configuration");
+    }
+    useClock = in.u64();
+    for (Line& line : lines) {
+        uint8_t flags = in.u8();
+        line.valid = (flags & 1) != 0;
+        line.dirty = (flags & 2) != 0;
+        line.tag = in.u32();
+        line.lastUse = in.u64();
+    }
+    for (uint32_t& bits : plruBits) bits = in.u32();
+}
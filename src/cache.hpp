@@ -0,0 +1,84 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include "checkpoint.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class Replacement : uint8_t { LRU, PLRU };
+
+// Geometry and timing of one L1 cache. Latencies are the cycles an access
+// keeps its stage busy, so a hit latency of 1 costs nothing extra.
+struct CacheConfig {
+    bool enabled = false;
+    uint32_t size = 4096;        // bytes
+    uint32_t ways = 2;
+    uint32_t lineSize = 32;      // bytes
+    Replacement replacement = Replacement::LRU;
+    uint32_t hitLatency = 1;
+    uint32_t missLatency = 10;
+    bool writeBack = true;       // otherwise write-through
+    bool writeAllocate = true;   // a write miss fills the line
+};
+
+// Parses "key=value,..." with keys size, ways, line, repl (lru|plru), hit,
+// miss, write (back|through) and alloc (yes|no); "default" keeps every
+// default. Sizes take an optional k suffix. Returns false with `error` set
+// on bad input.
+bool parseCacheConfig(const std::string& spec, CacheConfig& config, std::string& error);
+
+struct CacheStats {
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t misses = 0;
+    uint64_t writebacks = 0;     // dirty lines evicted
+    uint64_t stallCycles = 0;    // cycles beyond the first spent waiting on it
+};
+
+// Tag-only timing model: data always comes from DataMemory or the program,
+// the cache only decides how long an access takes. Write-backs and
+// write-through stores go to a buffer and cost no time.
+class CacheModel {
+public:
+    void configure(const CacheConfig& settings);  // throws std::invalid_argument
+    bool enabled() const { return config.enabled; }
+    const CacheConfig& settings() const { return config; }
+
+    // Looks the address up, updates tags and replacement state and
+    // `stats`, and returns the access latency in cycles.
+    uint32_t access(uint32_t address, bool write, CacheStats& stats);
+
+    // Drops the line holding `address` without a write-back, for a copy
+    // that another core's write has made stale. True if it was present.
+    bool invalidate(uint32_t address);
+
+    // True once after an access() that evicted a valid line, with
+    // `address` set to the first byte of that line.
+    bool takeEviction(uint32_t& address);
+
+    void save(CheckpointWriter& out) const;
+    void load(CheckpointReader& in);  // the checkpoint must use the same configuration
+
+private:
+    struct Line {
+        bool valid = false;
+        bool dirty = false;
+        uint32_t tag = 0;
+        uint64_t lastUse = 0;    // LRU
+    };
+
+    CacheConfig config;
+    std::vector<Line> lines;        // sets * ways
+    std::vector<uint32_t> plruBits; // one tree per set, ways - 1 bits
+    uint32_t sets = 0;
+    uint32_t lineBits = 0;
+    uint64_t useClock = 0;
+    bool evicted = false;
+    uint32_t evictedAddress = 0;
+
+    uint32_t victim(uint32_t set) const;
+    void touch(uint32_t set, uint32_t way);
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include "checkpoint.hpp"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+static const char MAGIC[8] = {'R', 'V', 'S', 'I', 'M', 'C', 'K', 'P'};
+static const uint32_t VERSION = 7;
+
+// FNV-1a over the machine code, so a checkpoint is not restored into a
+// different program.
+static uint64_t fingerprint(const Program& program) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const DecodedInstruction& instruction : program.instructions) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            hash ^= (instruction.machineCode >> shift) & 0xFF;
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    return hash;
+}
+
+void CheckpointWriter::u32(uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) data.push_back((value >> shift) & 0xFF);
+}
+
+void CheckpointWriter::u64(uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) data.push_back((value >> shift) & 0xFF);
+}
+
+void CheckpointWriter::bytes(const void* source, size_t length) {
+    const uint8_t* begin = static_cast<const uint8_t*>(source);
+    data.insert(data.end(), begin, begin + length);
+}
+
+void CheckpointWriter::string(const std::string& value) {
+    u32(static_cast<uint32_t>(value.size()));
+    bytes(value.data(), value.size());
+}
+
+void CheckpointWriter::header(const char* policyName, const Program& program) {
+    bytes(MAGIC, sizeof(MAGIC));
+    u32(VERSION);
+    string(policyName);
+    u32(static_cast<uint32_t>(program.size()));
+    u64(fingerprint(program));
+}
+
+void CheckpointWriter::archState(const ArchState& state) {
+    u32(state.pc);
+    for (int32_t value : state.registers) u32(static_cast<uint32_t>(value));
+    u32(state.programBreak);
+    u8(static_cast<uint8_t>(state.halt));
+    u32(static_cast<uint32_t>(state.exitCode));
+
+    static const uint8_t zeroPage[DataMemory::PAGE_SIZE] = {};
+    std::vector<std::pair<uint32_t, const uint8_t*>> pages;
+    state.memory.forEachPage([&](uint32_t pageNumber, const uint8_t* page) {
+        if (std::memcmp(page, zeroPage, DataMemory::PAGE_SIZE) != 0) pages.emplace_back(pageNumber, page);
+    });
+    u32(static_cast<uint32_t>(pages.size()));
+    for (const auto& [pageNumber, page] : pages) {
+        u32(pageNumber);
+        bytes(page, DataMemory::PAGE_SIZE);
+    }
+}
+
+void CheckpointWriter::writeTo(const std::string& path) const {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) throw std::runtime_error("Could not open checkpoint file: " + path);
+    size_t written = std::fwrite(data.data(), 1, data.size(), file);
+    bool ok = written == data.size() && std::fclose(file) == 0;
+    if (!ok) throw std::runtime_error("Could not write checkpoint file: " + path);
+}
+
+CheckpointReader::CheckpointReader(const std::string& path) : path(path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) throw std::runtime_error("Could not open checkpoint file: " + path);
+    uint8_t chunk[1 << 16];
+    size_t count;
+    while ((count = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + count);
+    }
+    std::fclose(file);
+}
+
+void CheckpointReader::need(size_t length) const {
+    if (data.size() - offset < length) {
+        throw std::runtime_error("Truncated checkpoint file: " + path);
+    }
+}
+
+uint8_t CheckpointReader::u8() {
+    need(1);
+    return data[offset++];
+}
+
+uint32_t CheckpointReader::u32() {
+    need(4);
+    uint32_t value = 0;
+    for (int shift = 0; shift < 32; shift += 8) value |= uint32_t(data[offset++]) << shift;
+    return value;
+}
+
+uint64_t CheckpointReader::u64() {
+    need(8);
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 8) value |= uint64_t(data[offset++]) << shift;
+    return value;
+}
+
+void CheckpointReader::bytes(void* destination, size_t length) {
+    need(length);
+    std::memcpy(destination, data.data() + offset, length);
+    offset += length;
+}
+
+std::string CheckpointReader::string() {
+    uint32_t length = u32();
+    need(length);
+    std::string value(reinterpret_cast<const char*>(data.data() + offset), length);
+    offset += length;
+    return value;
+}
+
+void CheckpointReader::header(const char* policyName, const Program& program) {
+    char magic[sizeof(MAGIC)];
+    bytes(magic, sizeof(magic));
+    if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a checkpoint file: " + path);
+    }
+    uint32_t version = u32();
+    if (version != VERSION) {
+        throw std::runtime_error("Unsupported checkpoint version " + std::to_string(version) + ": " + path);
+    }
+    std::string savedPolicy = string();
+    if (savedPolicy != policyName) {
+        throw std::runtime_error("Checkpoint was written by " + savedPolicy + ", not " + policyName + ": " + path);
+    }
+    uint32_t size = u32();
+    uint64_t hash = u64();
+    if (size != program.size() || hash != fingerprint(program)) {
+        throw std::runtime_error("Checkpoint was written for a different program: " + path);
+    }
+}
+
+void CheckpointReader::archState(ArchState& state) {
+    state.pc = u32();
+    for (int32_t& value : state.registers) value = static_cast<int32_t>(u32());
+    state.programBreak = u32();
+    uint8_t halt = u8();
+    if (halt > static_cast<uint8_t>(ProgramHalt::Breakpoint)) {
+        throw std::runtime_error("Checkpoint has an invalid program state: " + path);
+    }
+    state.halt = static_cast<ProgramHalt>(halt);
+    state.exitCode = static_cast<int32_t>(u32());
+
+    state.memory.clear();
+    uint32_t pageCount = u32();
+    uint8_t page[DataMemory::PAGE_SIZE];
+    for (uint32_t i = 0; i < pageCount; ++i) {
+        uint32_t pageNumber = u32();
+        bytes(page, sizeof(page));
+        state.memory.writePage(pageNumber, page);
+    }
+}
+
+void CheckpointReader::finish() const {
+    if (offset != data.size()) {
+        throw std::runtime_error("Unexpected data at the end of checkpoint file: " + path);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include "functional.hpp"
+#include "program.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Checkpoint files are a little-endian byte stream:
+//
+//     "RVSIMCKP" version policy-name program-fingerprint
+//     architectural state (pc, x0..x31, heap end and exit status,
+//     non-zero memory pages)
+//     engine state (cycle, latches, control flags; written by Processor)
+//
+// A checkpoint only restores into the same engine running the same program;
+// anything else is rejected with std::runtime_error.
+class CheckpointWriter {
+public:
+    void u8(uint8_t value) { data.push_back(value); }
+    void u32(uint32_t value);
+    void u64(uint64_t value);
+    void bytes(const void* source, size_t length);
+    void string(const std::string& value);
+
+    void header(const char* policyName, const Program& program);
+    void archState(const ArchState& state);
+
+    void writeTo(const std::string& path) const;
+
+private:
+    std::vector<uint8_t> data;
+};
+
+class CheckpointReader {
+public:
+    explicit CheckpointReader(const std::string& path);
+
+    uint8_t u8();
+    uint32_t u32();
+    uint64_t u64();
+    void bytes(void* destination, size_t length);
+    std::string string();
+
+    void header(const char* policyName, const Program& program);
+    void archState(ArchState& state);
+    void finish() const;  // throws if bytes are left over
+
+private:
+    std::vector<uint8_t> data;
+    size_t offset = 0;
+    std::string path;
+
+    void need(size_t length) const;
+};
+
+#endif
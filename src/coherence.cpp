@@ -0,0 +1,109 @@
+#include "coherence.hpp"
+
+const char* coherenceName(CoherenceProtocol protocol) {
+    return protocol == CoherenceProtocol::MSI ? "msi" : "mesi";
+}
+
+bool parseCoherenceProtocol(const std::string& name, CoherenceProtocol& protocol) {
+    if (name == "msi") protocol = CoherenceProtocol::MSI;
+    else if (name == "mesi") protocol = CoherenceProtocol::MESI;
+    else return false;
+    return true;
+}
+
+void CoherenceStats::writeJson(std::ostream& out, CoherenceProtocol protocol) const {
+    out << "{\"protocol\": \"" << coherenceName(protocol) << "\", \"read_misses\": " << readMisses
+        << ", \"write_misses\": " << writeMisses << ", \"upgrades\": " << upgrades
+        << ", \"silent_upgrades\": " << silentUpgrades << ", \"invalidations\": " << invalidations
+        << ", \"interventions\": " << interventions << ", \"writebacks\": " << writebacks << "}";
+}
+
+int32_t SharedMemory::load(uint32_t address, uint8_t memOp) {
+    std::lock_guard<std::mutex> guard(lock);
+    return memory.load(address, memOp);
+}
+
+void SharedMemory::store(uint32_t address, uint8_t memOp, uint32_t value) {
+    std::lock_guard<std::mutex> guard(lock);
+    memory.store(address, memOp, value);
+}
+
+CoherenceStats SharedMemory::statistics() {
+    std::lock_guard<std::mutex> guard(lock);
+    return stats;
+}
+
+// Another core takes the line for writing: every other copy goes, and a
+// Modified one is written back on the way.
+void SharedMemory::invalidateOthers(int core, DirectoryEntry& entry) {
+    uint32_t others = entry.sharers & ~(1u << core);
+    for (; others; others &= others - 1) ++stats.invalidations;
+    if (entry.owner >= 0 && entry.owner != core && entry.dirty) {
+        ++stats.interventions;
+        ++stats.writebacks;
+    }
+    entry.sharers &= 1u << core;
+}
+
+// `core`'s L1 replaced the line; a Modified copy goes back to memory.
+void SharedMemory::evict(int core, uint32_t line) {
+    auto found = directory.find(line);
+    if (found == directory.end()) return;
+    DirectoryEntry& entry = found->second;
+    entry.sharers &= ~(1u << core);
+    if (entry.owner == core) {
+        if (entry.dirty) ++stats.writebacks;
+        entry.owner = -1;
+        entry.dirty = false;
+    }
+    if (!entry.sharers) directory.erase(found);
+}
+
+uint32_t SharedMemory::access(int core, uint32_t address, bool write, CacheModel& cache, CacheStats& cacheStats) {
+    const CacheConfig& config = cache.settings();
+    uint32_t lineBits = 0;
+    while ((1u << lineBits) < config.lineSize) ++lineBits;
+    uint32_t line = address >> lineBits;
+    uint32_t coreBit = 1u << core;
+
+    std::lock_guard<std::mutex> guard(lock);
+    DirectoryEntry& entry = directory[line];
+    bool present = (entry.sharers & coreBit) != 0;
+    if (!present) cache.invalidate(address);  // stale tags from before another core's write
+
+    uint32_t latency = cache.access(address, write, cacheStats);
+    uint32_t victim = 0;
+    if (cache.takeEviction(victim) && (victim >> lineBits) != line) evict(core, victim >> lineBits);
+
+    if (!present) {
+        ++(write ? stats.writeMisses : stats.readMisses);
+        if (write) {
+            invalidateOthers(core, entry);
+            entry.owner = static_cast<int8_t>(core);
+            entry.dirty = true;
+        } else {
+            if (entry.owner >= 0 && entry.dirty) {
+                // The owner supplies the data and keeps a Shared copy
+                ++stats.interventions;
+                ++stats.writebacks;
+            }
+            bool alone = entry.sharers == 0;
+            entry.owner = -1;
+            entry.dirty = false;
+            if (alone && protocol == CoherenceProtocol::MESI) entry.owner = static_cast<int8_t>(core);
+        }
+        entry.sharers |= coreBit;
+    } else if (write && entry.owner != core) {
+        // Shared: the other copies have to be invalidated over the bus
+        ++stats.upgrades;
+        invalidateOthers(core, entry);
+        entry.owner = static_cast<int8_t>(core);
+        entry.dirty = true;
+        cacheStats.stallCycles += config.missLatency - latency;
+        latency = config.missLatency;
+    } else if (write && !entry.dirty) {
+        ++stats.silentUpgrades;
+        entry.dirty = true;
+    }
+    return latency;
+}
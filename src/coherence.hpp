@@ -0,0 +1,88 @@
+#ifndef COHERENCE_HPP
+#define COHERENCE_HPP
+
+#include "cache.hpp"
+#include "memory.hpp"
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+// Cores in a multi-core run; the directory keeps one bit per core.
+const int MAX_CORES = 32;
+
+enum class CoherenceProtocol : uint8_t {
+    MSI,   // a read miss always fills in Shared
+    MESI   // a read miss nobody else holds fills in Exclusive, and a later write needs no bus request
+};
+
+const char* coherenceName(CoherenceProtocol protocol);
+bool parseCoherenceProtocol(const std::string& name, CoherenceProtocol& protocol);
+
+// Coherence traffic of a whole multi-core run.
+struct CoherenceStats {
+    uint64_t readMisses = 0;      // a read with no valid copy in the core's L1
+    uint64_t writeMisses = 0;     // a write with no valid copy (read for ownership)
+    uint64_t upgrades = 0;        // a write to a Shared copy
+    uint64_t silentUpgrades = 0;  // a write to an Exclusive copy (MESI only)
+    uint64_t invalidations = 0;   // copies removed from other cores' L1s
+    uint64_t interventions = 0;   // a Modified copy supplied another core's miss
+    uint64_t writebacks = 0;      // Modified data returned to memory
+
+    void writeJson(std::ostream& out, CoherenceProtocol protocol) const;
+};
+
+// Data memory shared by every core of a multi-core run, with a directory
+// that keeps the cores' private D-caches coherent. The directory records
+// which cores hold each line and which one, if any, owns it in Exclusive
+// or Modified state. A core's cache model is only touched by that core:
+// a copy invalidated by another core is dropped from its tags the next
+// time the core accesses the line. Every method may be called from any
+// core's thread; one lock serialises them, so loads and stores are
+// sequentially consistent.
+class SharedMemory {
+public:
+    explicit SharedMemory(CoherenceProtocol protocol) : protocol(protocol) {}
+
+    // For loading the program before the cores start.
+    DataMemory& data() { return memory; }
+    void setProgramBreak(uint32_t address) { programBreak = address; }
+    CoherenceProtocol settings() const { return protocol; }
+
+    int32_t load(uint32_t address, uint8_t memOp);
+    void store(uint32_t address, uint8_t memOp, uint32_t value);
+    // Runs fn(DataMemory&, uint32_t& programBreak) under the lock, e.g. a
+    // system call's buffer copy. The cores share one heap, so brk moves
+    // this break rather than a core's own.
+    template <typename Fn>
+    void exclusive(Fn&& fn) {
+        std::lock_guard<std::mutex> guard(lock);
+        fn(memory, programBreak);
+    }
+
+    // Runs `core`'s access through its L1 `cache` and the protocol, and
+    // returns the latency. A miss or an upgrade costs the miss latency.
+    uint32_t access(int core, uint32_t address, bool write, CacheModel& cache, CacheStats& stats);
+
+    CoherenceStats statistics();
+
+private:
+    struct DirectoryEntry {
+        uint32_t sharers = 0;  // bit per core holding a valid copy
+        int8_t owner = -1;     // core holding it Exclusive or Modified
+        bool dirty = false;    // the owner's copy is Modified
+    };
+
+    CoherenceProtocol protocol;
+    std::mutex lock;
+    DataMemory memory;
+    uint32_t programBreak = 0;
+    std::unordered_map<uint32_t, DirectoryEntry> directory;  // by line number
+    CoherenceStats stats;
+
+    void evict(int core, uint32_t line);
+    void invalidateOthers(int core, DirectoryEntry& entry);
+};
+
+#endif
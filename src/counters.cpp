@@ -0,0 +1,116 @@
+#include "counters.hpp"
+#include <cstdio>
+
+static const char* const STALL_NAMES[] = {"none", "load_use", "branch_operand", "writeback", "dcache", "muldiv",
+                                          "muldiv_busy", "group_dependency", "mem_ports",
+                                          "serialize", "ex_latency"};
+static const char* const FORWARD_NAMES[] = {"ex_mem_to_ex", "mem_wb_to_ex", "ex_mem_to_id",
+                                            "mem_wb_to_id", "mem_wb_to_mem"};
+
+const char* stallCauseName(StallCause cause) {
+    return STALL_NAMES[static_cast<int>(cause)];
+}
+
+void PerfCounters::reset(size_t instructionCount, bool withIcache, bool withDcache, int width) {
+    *this = PerfCounters();
+    icacheModelled = withIcache;
+    dcacheModelled = withDcache;
+    issueWidth = width;
+    issueGroups.assign(width ? width + 1 : 0, 0);
+    slotIssued.assign(width, 0);
+    perPc.assign(instructionCount, {});
+}
+
+static void writeCache(std::ostream& out, const char* name, bool modelled, const CacheStats& stats) {
+    out << "\"" << name << "\": ";
+    if (!modelled) {
+        out << "null";
+        return;
+    }
+    out << "{\"reads\": " << stats.reads << ", \"writes\": " << stats.writes << ", \"misses\": " << stats.misses
+        << ", \"writebacks\": " << stats.writebacks << ", \"stall_cycles\": " << stats.stallCycles << "}";
+}
+
+static void writeString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+void PerfCounters::writeJson(std::ostream& out, const char* engine, const char* predictor,
+                             const std::vector<std::string>& labels, uint32_t base) const {
+    uint64_t totalStalls = 0;
+    for (int cause = 1; cause < static_cast<int>(StallCause::Count); ++cause) totalStalls += stalls[cause];
+
+    out << "{\n  \"engine\": \"" << engine << "\",\n";
+    out << "  \"cycles\": " << cycles << ",\n";
+    out << "  \"retired\": " << retired << ",\n";
+    out << "  \"cpi\": ";
+    if (retired) out << static_cast<double>(cycles) / retired;
+    else out << "null";
+    out << ",\n";
+
+    out << "  \"stalls\": {\"total\": " << totalStalls;
+    for (int cause = 1; cause < static_cast<int>(StallCause::Count); ++cause) {
+        out << ", \"" << STALL_NAMES[cause] << "\": " << stalls[cause];
+    }
+    out << "},\n";
+    out << "  \"flushes\": " << flushes << ",\n";
+
+    out << "  \"forwards\": {";
+    for (int path = 0; path < static_cast<int>(ForwardPath::Count); ++path) {
+        out << (path ? ", \"" : "\"") << FORWARD_NAMES[path] << "\": " << forwards[path];
+    }
+    out << "},\n";
+
+    out << "  \"branches\": {\"predictor\": \"" << predictor << "\", \"conditional\": " << conditionalBranches
+        << ", \"conditional_mispredicted\": " << conditionalMispredicts << ", \"jumps\": " << jumps
+        << ", \"jumps_mispredicted\": " << jumpMispredicts << ", \"btb_lookups\": " << btbLookups
+        << ", \"btb_hits\": " << btbHits << "},\n";
+
+    out << "  \"caches\": {";
+    writeCache(out, "icache", icacheModelled, icache);
+    out << ", ";
+    writeCache(out, "dcache", dcacheModelled, dcache);
+    out << "},\n";
+
+    out << "  \"issue\": ";
+    if (issueWidth) {
+        out << "{\"width\": " << issueWidth << ", \"ipc\": ";
+        if (cycles) out << static_cast<double>(retired) / cycles;
+        else out << "null";
+        out << ", \"groups\": [";
+        for (size_t size = 0; size < issueGroups.size(); ++size) out << (size ? ", " : "") << issueGroups[size];
+        out << "], \"slots\": [";
+        for (size_t slot = 0; slot < slotIssued.size(); ++slot) out << (slot ? ", " : "") << slotIssued[slot];
+        out << "]}";
+    } else {
+        out << "null";
+    }
+    out << ",\n";
+
+    out << "  \"per_pc\": [";
+    bool first = true;
+    char pc[16];
+    for (size_t row = 0; row < perPc.size(); ++row) {
+        const PcCounts& counts = perPc[row];
+        if (!counts.retired && !counts.stallCycles && !counts.flushed) continue;
+        std::snprintf(pc, sizeof(pc), "0x%08x", static_cast<unsigned>(base + row * 4));
+        out << (first ? "\n" : ",\n") << "    {\"pc\": \"" << pc << "\", \"instruction\": ";
+        writeString(out, row < labels.size() ? labels[row] : std::string());
+        out << ", \"retired\": " << counts.retired << ", \"stall_cycles\": " << counts.stallCycles
+            << ", \"flushed\": " << counts.flushed << "}";
+        first = false;
+    }
+    out << (first ? "]\n" : "\n  ]\n") << "}\n";
+}
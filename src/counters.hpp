@@ -0,0 +1,100 @@
+#ifndef COUNTERS_HPP
+#define COUNTERS_HPP
+
+#include "cache.hpp"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Why ID held its instruction in a cycle.
+enum class StallCause : uint8_t {
+    None = 0,
+    LoadUse,        // a load result is needed before MEM has produced it
+    BranchOperand,  // a branch or jalr read in ID waits for an operand
+    Writeback,      // no forwarding: the producer has not written back yet
+    DataCache,      // MEM is waiting on the D-cache, freezing the stages behind it
+    MulDivResult,   // an operand is still being computed by the multiply/divide unit
+    MulDivBusy,     // the multiplier or divider cannot take another operation yet
+    GroupDependency,  // wide issue: an operand comes from an older instruction issuing this cycle
+    MemoryPorts,    // wide issue: every memory port is taken this cycle
+    Serialize,      // ECALL or EBREAK waits for the instructions ahead of it
+    ExecuteLatency,  // an operand is still in a multi-cycle EX (see --depth)
+    Count
+};
+
+// The name of `cause` in --stats, e.g. "load_use".
+const char* stallCauseName(StallCause cause);
+
+// Bypass paths, named by source latch and the consuming stage.
+enum class ForwardPath : uint8_t {
+    ExMemToEx = 0,
+    MemWbToEx,
+    ExMemToId,
+    MemWbToId,
+    MemWbToMem,
+    Count
+};
+
+// Event counts for one run of the pipeline. Cycles and instructions are
+// counted from the start of runSimulation(); the per-PC table is indexed
+// by program row, (address - base) / 4, like the diagram.
+struct PerfCounters {
+    struct PcCounts {
+        uint64_t retired = 0;
+        uint64_t stallCycles = 0;  // cycles held in ID
+        uint64_t flushed = 0;      // times squashed on the wrong path
+    };
+
+    uint64_t cycles = 0;
+    uint64_t retired = 0;
+    uint64_t flushes = 0;
+    uint64_t stalls[static_cast<int>(StallCause::Count)] = {};
+    uint64_t forwards[static_cast<int>(ForwardPath::Count)] = {};
+    uint64_t conditionalBranches = 0;
+    uint64_t conditionalMispredicts = 0;
+    uint64_t jumps = 0;
+    uint64_t jumpMispredicts = 0;
+    uint64_t btbLookups = 0;
+    uint64_t btbHits = 0;
+    bool icacheModelled = false;  // the cache sections are null otherwise
+    bool dcacheModelled = false;
+    CacheStats icache;
+    CacheStats dcache;
+    int issueWidth = 0;                 // wide pipelines only; the issue section is null otherwise
+    std::vector<uint64_t> issueGroups;  // cycles by the number of instructions ID issued
+    std::vector<uint64_t> slotIssued;   // instructions issued into each EX slot
+    std::vector<PcCounts> perPc;
+
+    void reset(size_t instructionCount, bool withIcache, bool withDcache, int width = 0);
+    void stall(StallCause cause, size_t row, uint64_t cycles = 1) {
+        stalls[static_cast<int>(cause)] += cycles;
+        if (row < perPc.size()) perPc[row].stallCycles += cycles;
+    }
+    void forward(ForwardPath path) { ++forwards[static_cast<int>(path)]; }
+    void retire(size_t row) {
+        ++retired;
+        if (row < perPc.size()) ++perPc[row].retired;
+    }
+    // A resolved branch or jump; `correct` when fetch already followed it.
+    void resolve(bool conditional, bool correct) {
+        if (conditional) {
+            ++conditionalBranches;
+            if (!correct) ++conditionalMispredicts;
+        } else {
+            ++jumps;
+            if (!correct) ++jumpMispredicts;
+        }
+    }
+    void flush(size_t row) {
+        ++flushes;
+        if (row < perPc.size()) ++perPc[row].flushed;
+    }
+
+    // One JSON object; PCs with nothing counted are left out of "per_pc".
+    // Row r is reported at address base + 4 * r.
+    void writeJson(std::ostream& out, const char* engine, const char* predictor,
+                   const std::vector<std::string>& labels, uint32_t base) const;
+};
+
+#endif
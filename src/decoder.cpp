@@ -0,0 +1,161 @@
+#include "decoder.hpp"
+#include <iostream>
+
+const DecodedInstruction NOP_INSTRUCTION{};
+
+static DecodedInstruction bubble(DecodedInstruction details) {
+    details.flags = DEC_BUBBLE;
+    details.srcMask = 0;
+    details.destMask = 0;
+    return details;
+}
+
+DecodedInstruction predecode(uint32_t machineCode, uint32_t address) {
+    DecodedInstruction details;
+    details.machineCode = machineCode;
+
+    // Extract instruction fields
+    details.opcode = machineCode & 0x7F;
+    details.destReg = (machineCode >> 7) & 0x1F;
+    details.func3 = (machineCode >> 12) & 0x7;
+    details.srcReg1 = (machineCode >> 15) & 0x1F;
+    details.srcReg2 = (machineCode >> 20) & 0x1F;
+    details.func7 = (machineCode >> 25) & 0x7F;
+    details.flags = 0;
+
+    int32_t immI = (int32_t)(machineCode & 0xFFF00000) >> 20;
+
+    switch (details.opcode) {
+        case 0x33: // R-type
+            details.flags = DEC_REG_WRITE | DEC_USES_RS1 | DEC_USES_RS2;
+            if (details.func7 == 0x01) { // RV32M
+                details.flags |= DEC_MULDIV;
+                details.aluOp = ALU_MUL + details.func3;
+                break;
+            }
+            switch (details.func3) {
+                case 0x0: details.aluOp = details.func7 == 0x20 ? ALU_SUB : ALU_ADD; break;
+                case 0x1: details.aluOp = ALU_SLL; break;
+                case 0x2: details.aluOp = ALU_SLT; break;
+                case 0x3: details.aluOp = ALU_SLTU; break;
+                case 0x4: details.aluOp = ALU_XOR; break;
+                case 0x5: details.aluOp = details.func7 == 0x20 ? ALU_SRA : ALU_SRL; break;
+                case 0x6: details.aluOp = ALU_OR; break;
+                case 0x7: details.aluOp = ALU_AND; break;
+            }
+            break;
+
+        case 0x13: // I-type ALU
+            details.flags = DEC_REG_WRITE | DEC_USES_RS1 | DEC_ALU_IMM;
+            if (machineCode == 0x00000013) details.flags |= DEC_BUBBLE; // NOP
+            details.immediate = immI;
+            switch (details.func3) {
+                case 0x0: details.aluOp = ALU_ADD; break;
+                case 0x1: details.aluOp = ALU_SLL; details.immediate &= 0x1F; break;
+                case 0x2: details.aluOp = ALU_SLT; break;
+                case 0x3: details.aluOp = ALU_SLTU; break;
+                case 0x4: details.aluOp = ALU_XOR; break;
+                case 0x5:
+                    details.aluOp = details.func7 == 0x20 ? ALU_SRA : ALU_SRL;
+                    details.immediate &= 0x1F;
+                    break;
+                case 0x6: details.aluOp = ALU_OR; break;
+                case 0x7: details.aluOp = ALU_AND; break;
+            }
+            break;
+
+        case 0x03: // I-type Load
+            details.flags = DEC_REG_WRITE | DEC_USES_RS1 | DEC_ALU_IMM | DEC_MEM_READ;
+            details.immediate = immI;
+            switch (details.func3) {
+                case 0x0: details.memOp = MEM_BYTE; break;
+                case 0x1: details.memOp = MEM_HALF; break;
+                case 0x4: details.memOp = MEM_BYTE_UNSIGNED; break;
+                case 0x5: details.memOp = MEM_HALF_UNSIGNED; break;
+                default: details.memOp = MEM_WORD;
+            }
+            break;
+
+        case 0x23: // S-type Store
+            details.flags = DEC_USES_RS1 | DEC_USES_RS2 | DEC_ALU_IMM | DEC_MEM_WRITE;
+            details.immediate = ((int32_t)(machineCode & 0xFE000000) >> 20) |
+                               ((machineCode >> 7) & 0x1F);
+            switch (details.func3) {
+                case 0x0: details.memOp = MEM_BYTE; break;
+                case 0x1: details.memOp = MEM_HALF; break;
+                default: details.memOp = MEM_WORD;
+            }
+            break;
+
+        case 0x63: // B-type Branch
+            details.flags = DEC_USES_RS1 | DEC_USES_RS2;
+            details.branchKind = BRANCH_CONDITIONAL;
+            details.immediate = (((int32_t)(machineCode & 0x80000000) >> 19)) |
+                               ((machineCode & 0x80) << 4) |
+                               ((machineCode >> 20) & 0x7E0) |
+                               ((machineCode >> 7) & 0x1E);
+            switch (details.func3) {
+                case 0x1: details.branchOp = BRANCH_NE; break;
+                case 0x4: details.branchOp = BRANCH_LT; break;
+                case 0x5: details.branchOp = BRANCH_GE; break;
+                case 0x6: details.branchOp = BRANCH_LTU; break;
+                case 0x7: details.branchOp = BRANCH_GEU; break;
+                default: details.branchOp = BRANCH_EQ;
+            }
+            break;
+
+        case 0x6F: // J-type JAL
+            details.flags = DEC_REG_WRITE;
+            details.branchKind = BRANCH_JAL;
+            details.immediate = (((int32_t)(machineCode & 0x80000000) >> 11)) |
+                               (machineCode & 0xFF000) |
+                               ((machineCode >> 9) & 0x800) |
+                               ((machineCode >> 20) & 0x7FE);
+            break;
+
+        case 0x67: // I-type JALR
+            if (details.func3 != 0x0) {
+                std::cerr << "Warning: Unknown JALR funct3 at 0x" << std::hex << address << std::dec << std::endl;
+                return bubble(details);
+            }
+            details.flags = DEC_REG_WRITE | DEC_USES_RS1 | DEC_ALU_IMM;
+            details.branchKind = BRANCH_JALR;
+            details.immediate = immI;
+            break;
+
+        case 0x37: // U-type LUI: x0 + imm
+            details.flags = DEC_REG_WRITE | DEC_ALU_IMM;
+            details.immediate = (int32_t)(machineCode & 0xFFFFF000);
+            break;
+
+        case 0x17: // U-type AUIPC: the PC is known here, so fold it into the immediate
+            details.flags = DEC_REG_WRITE | DEC_ALU_IMM;
+            details.immediate = (int32_t)((machineCode & 0xFFFFF000) + address);
+            break;
+
+        case 0x73: // System: ECALL and EBREAK read and write registers outside the masks
+            if (machineCode == 0x00000073) details.system = SYSTEM_ECALL;
+            else if (machineCode == 0x00100073) details.system = SYSTEM_EBREAK;
+            else {
+                std::cerr << "Warning: CSR access at 0x" << std::hex << address << std::dec
+                          << " is not supported" << std::endl;
+                return bubble(details);
+            }
+            return details;
+
+        case 0x0F: // Fence: memory is never reordered, so there is nothing to wait for
+        case 0x00: // Zero instruction
+            return bubble(details);
+
+        default:
+            std::cerr << "Warning: Unknown opcode 0x" << std::hex << (int)details.opcode
+                      << " at 0x" << address << std::dec << std::endl;
+            return bubble(details);
+    }
+
+    if (details.has(DEC_USES_RS1)) details.srcMask |= 1u << details.srcReg1;
+    if (details.has(DEC_USES_RS2)) details.srcMask |= 1u << details.srcReg2;
+    details.srcMask &= ~1u;
+    if (details.has(DEC_REG_WRITE) && details.destReg != 0) details.destMask = 1u << details.destReg;
+    return details;
+}
@@ -0,0 +1,148 @@
+#ifndef DECODER_HPP
+#define DECODER_HPP
+
+#include <cstdint>
+
+// ALU operations, numbered as the forwarding engine's alu_op values.
+enum AluOp : uint8_t {
+    ALU_ADD = 0,
+    ALU_SUB = 1,
+    ALU_XOR = 2,
+    ALU_AND = 3,
+    ALU_OR = 4,
+    ALU_SLL = 5,
+    ALU_SRL = 6,
+    ALU_SRA = 7,
+    ALU_SLT = 8,
+    ALU_SLTU = 9,
+    // RV32M, in funct3 order
+    ALU_MUL = 10,
+    ALU_MULH = 11,
+    ALU_MULHSU = 12,
+    ALU_MULHU = 13,
+    ALU_DIV = 14,
+    ALU_DIVU = 15,
+    ALU_REM = 16,
+    ALU_REMU = 17,
+    ALU_OP_COUNT
+};
+
+// Memory access widths, numbered as the forwarding engine's mem_op values.
+enum MemOp : uint8_t {
+    MEM_BYTE = 0,
+    MEM_HALF = 1,
+    MEM_WORD = 2,
+    MEM_BYTE_UNSIGNED = 3,
+    MEM_HALF_UNSIGNED = 4
+};
+
+// Control transfer kind, numbered as the forwarding engine's branch field.
+enum BranchKind : uint8_t {
+    BRANCH_NONE = 0,
+    BRANCH_CONDITIONAL = 1,
+    BRANCH_JAL = 2,
+    BRANCH_JALR = 3
+};
+
+// Conditional branch comparisons (BEQ, BNE, BLT, BGE, BLTU, BGEU).
+enum BranchOp : uint8_t {
+    BRANCH_EQ = 0,
+    BRANCH_NE = 1,
+    BRANCH_LT = 2,
+    BRANCH_GE = 3,
+    BRANCH_LTU = 4,
+    BRANCH_GEU = 5
+};
+
+// ECALL and EBREAK, which stop the pipeline behind them (see SystemCalls).
+enum SystemOp : uint8_t {
+    SYSTEM_NONE = 0,
+    SYSTEM_ECALL = 1,
+    SYSTEM_EBREAK = 2
+};
+
+enum DecodeFlags : uint8_t {
+    DEC_REG_WRITE = 1 << 0, // instruction class writes rd (rd may still be x0)
+    DEC_MEM_READ = 1 << 1,
+    DEC_MEM_WRITE = 1 << 2,
+    DEC_ALU_IMM = 1 << 3,   // second ALU operand is the immediate
+    DEC_USES_RS1 = 1 << 4,
+    DEC_USES_RS2 = 1 << 5,
+    DEC_BUBBLE = 1 << 6,    // nop, fence, CSR access or unknown encoding
+    DEC_MULDIV = 1 << 7     // RV32M: runs on the multiply/divide unit
+};
+
+// Everything the pipeline needs to know about one static instruction,
+// extracted once when the program is loaded and indexed by Program::index().
+struct DecodedInstruction {
+    uint32_t machineCode = 0x00000013;
+    int32_t immediate = 0;  // sign-extended; AUIPC already has its own PC added
+    uint32_t srcMask = 0;   // bit i set when xi is read (x0 never set)
+    uint32_t destMask = 0;  // bit rd set when rd is written (x0 never set)
+
+    uint8_t opcode = 0x13;
+    uint8_t destReg = 0;
+    uint8_t func3 = 0;
+    uint8_t srcReg1 = 0;    // raw rs1 field, whether or not it is read
+    uint8_t srcReg2 = 0;    // raw rs2 field, whether or not it is read
+    uint8_t func7 = 0;
+
+    uint8_t aluOp = ALU_ADD;
+    uint8_t memOp = MEM_WORD;
+    uint8_t branchKind = BRANCH_NONE;
+    uint8_t branchOp = BRANCH_EQ;
+    uint8_t system = SYSTEM_NONE;
+    uint8_t flags = DEC_REG_WRITE | DEC_ALU_IMM | DEC_USES_RS1 | DEC_BUBBLE;
+
+    bool has(uint8_t flag) const { return (flags & flag) != 0; }
+    bool isJump() const { return branchKind == BRANCH_JAL || branchKind == BRANCH_JALR; }
+};
+
+// Integer ALU shared by every engine. Division by zero and INT_MIN / -1
+// give the results the M extension specifies instead of trapping.
+inline int32_t aluCompute(uint8_t op, int32_t a, int32_t b) {
+    uint32_t ua = static_cast<uint32_t>(a);
+    uint32_t ub = static_cast<uint32_t>(b);
+    bool overflow = a == INT32_MIN && b == -1;
+    switch (op) {
+        case ALU_SUB: return static_cast<int32_t>(ua - ub);
+        case ALU_XOR: return a ^ b;
+        case ALU_AND: return a & b;
+        case ALU_OR: return a | b;
+        case ALU_SLL: return static_cast<int32_t>(ua << (ub & 0x1F));
+        case ALU_SRL: return static_cast<int32_t>(ua >> (ub & 0x1F));
+        case ALU_SRA: return a >> (ub & 0x1F);
+        case ALU_SLT: return a < b ? 1 : 0;
+        case ALU_SLTU: return ua < ub ? 1 : 0;
+        case ALU_MUL: return static_cast<int32_t>(ua * ub);
+        case ALU_MULH: return static_cast<int32_t>((static_cast<int64_t>(a) * b) >> 32);
+        case ALU_MULHSU: return static_cast<int32_t>((static_cast<int64_t>(a) * static_cast<int64_t>(ub)) >> 32);
+        case ALU_MULHU: return static_cast<int32_t>((static_cast<uint64_t>(ua) * ub) >> 32);
+        case ALU_DIV: return b == 0 ? -1 : overflow ? a : a / b;
+        case ALU_DIVU: return ub == 0 ? -1 : static_cast<int32_t>(ua / ub);
+        case ALU_REM: return b == 0 ? a : overflow ? 0 : a % b;
+        case ALU_REMU: return ub == 0 ? a : static_cast<int32_t>(ua % ub);
+        default: return static_cast<int32_t>(ua + ub);
+    }
+}
+
+inline bool branchTaken(uint8_t op, int32_t a, int32_t b) {
+    switch (op) {
+        case BRANCH_NE: return a != b;
+        case BRANCH_LT: return a < b;
+        case BRANCH_GE: return a >= b;
+        case BRANCH_LTU: return static_cast<uint32_t>(a) < static_cast<uint32_t>(b);
+        case BRANCH_GEU: return static_cast<uint32_t>(a) >= static_cast<uint32_t>(b);
+        default: return a == b;
+    }
+}
+
+// addi x0, x0, 0 -- used to initialise empty pipeline latches.
+extern const DecodedInstruction NOP_INSTRUCTION;
+
+// Decodes one RV32IM instruction located at `address`. Unknown encodings
+// are reported on stderr each time they are decoded, i.e. when the program
+// is loaded, and come back as bubbles.
+DecodedInstruction predecode(uint32_t machineCode, uint32_t address);
+
+#endif
@@ -0,0 +1,85 @@
+#include "depth.hpp"
+#include <sstream>
+#include <stdexcept>
+
+static bool parseStages(const std::string& text, int& value) {
+    try {
+        size_t used = 0;
+        int number = std::stoi(text, &used, 10);
+        if (used != text.size() || number < 1 || number > MAX_SUBSTAGES) return false;
+        value = number;
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool DepthConfig::isDefault() const {
+    return fetchStages == 1 && executeStages == 1 && memoryStages == 1 && aluLatency == 1 && loadStage() == 1 &&
+           storeLatency == 1 && branchLatency == 1;
+}
+
+int DepthConfig::stages(Stage stage) const {
+    switch (stage) {
+        case Stage::IF: return fetchStages;
+        case Stage::EX: return executeStages;
+        case Stage::MEM: return memoryStages;
+        default: return 1;
+    }
+}
+
+int DepthConfig::column(Stage stage, int index) const {
+    switch (stage) {
+        case Stage::IF: return index;
+        case Stage::ID: return fetchStages;
+        case Stage::EX: return fetchStages + 1 + index;
+        case Stage::MEM: return fetchStages + 1 + executeStages + index;
+        default: return fetchStages + 1 + executeStages + memoryStages;
+    }
+}
+
+uint8_t DepthConfig::label(Stage stage, int index) const {
+    return stages(stage) > 1 ? static_cast<uint8_t>(index + 1) : 0;
+}
+
+bool parseDepthConfig(const std::string& spec, DepthConfig& config, std::string& error) {
+    if (spec == "default") return true;
+
+    std::stringstream fields(spec);
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+        size_t equals = field.find('=');
+        std::string key = field.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : field.substr(equals + 1);
+        bool ok = true;
+        if (key == "if") ok = parseStages(value, config.fetchStages);
+        else if (key == "ex") ok = parseStages(value, config.executeStages);
+        else if (key == "mem") ok = parseStages(value, config.memoryStages);
+        else if (key == "alu") ok = parseStages(value, config.aluLatency);
+        else if (key == "load") ok = parseStages(value, config.loadLatency);
+        else if (key == "store") ok = parseStages(value, config.storeLatency);
+        else if (key == "branch") ok = parseStages(value, config.branchLatency);
+        else ok = false;
+        if (!ok) {
+            error = "Invalid pipeline depth setting '" + field + "'";
+            return false;
+        }
+    }
+    if (config.aluLatency > config.executeStages) {
+        error = "alu=" + std::to_string(config.aluLatency) + " is past the last EX sub-stage";
+        return false;
+    }
+    if (config.branchLatency > config.executeStages) {
+        error = "branch=" + std::to_string(config.branchLatency) + " is past the last EX sub-stage";
+        return false;
+    }
+    if (config.loadLatency > config.memoryStages) {
+        error = "load=" + std::to_string(config.loadLatency) + " is past the last MEM sub-stage";
+        return false;
+    }
+    if (config.storeLatency > config.memoryStages) {
+        error = "store=" + std::to_string(config.storeLatency) + " is past the last MEM sub-stage";
+        return false;
+    }
+    return true;
+}
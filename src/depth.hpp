@@ -0,0 +1,39 @@
+#ifndef DEPTH_HPP
+#define DEPTH_HPP
+
+#include "history.hpp"
+#include <string>
+
+// How far a pipeline splits IF, EX and MEM, and in which sub-stage each
+// instruction class has its result or needs its operand. ID and WB always
+// take one cycle. Results are bypassed from the end of the sub-stage that
+// produces them; RV32M latencies come from --muldiv as before.
+struct DepthConfig {
+    int fetchStages = 1;    // IF1..IFn: a taken branch costs n fetch cycles
+    int executeStages = 1;  // EX1..EXn
+    int memoryStages = 1;   // MEM1..MEMn
+    int aluLatency = 1;     // EX sub-stage with ALU results and link values
+    int loadLatency = 0;    // MEM sub-stage with loaded data; 0 for the last
+    int storeLatency = 1;   // MEM sub-stage that needs a store's data
+    int branchLatency = 1;  // EX sub-stage that resolves branches and jumps,
+                            // in engines that resolve them in EX
+
+    bool isDefault() const;
+    int stages(Stage stage) const;  // sub-stages of `stage`
+    int loadStage() const { return loadLatency ? loadLatency : memoryStages; }
+
+    // Stages are drawn and streamed one column per sub-stage, from IF1 to
+    // WB. `column` numbers them from 0; `label` is the number a sub-stage
+    // is drawn with, or 0 for a stage that is not split.
+    int columns() const { return fetchStages + executeStages + memoryStages + 2; }
+    int column(Stage stage, int index) const;
+    uint8_t label(Stage stage, int index) const;
+};
+
+// Parses "key=value,..." with keys if, ex and mem (sub-stages, 1 to
+// MAX_SUBSTAGES), alu and branch (1 to ex), and load and store (1 to mem);
+// "default" keeps the five-stage pipeline. Returns false with `error` set
+// on bad input.
+bool parseDepthConfig(const std::string& spec, DepthConfig& config, std::string& error);
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef DRIVER_HPP
+#define DRIVER_HPP
+
+#include "options.hpp"
+#include "functional.hpp"
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Runs `write` on stdout for the path "-", else on the file at `path`;
+// `what` names the file in errors.
+template <typename Write>
+void writeReport(const std::string& path, const char* what, Write write) {
+    if (path == "-") {
+        write(std::cout);
+        return;
+    }
+    std::ofstream file(path);
+    if (!file.is_open()) throw std::runtime_error(std::string("Could not open ") + what + " file: " + path);
+    write(file);
+}
+
+// The part of every simulator's main() after the command line is parsed:
+// configures `simulator`, loads and runs the program and reports the
+// result. Errors are printed as runtime errors and give exit status 1.
+// `Simulator` is a Processor<Policy> or the WideProcessor.
+template <typename Simulator>
+int runWithOptions(Simulator& simulator, const SimOptions& options) {
+    try {
+        simulator.setPredictor(options.predictor);
+        simulator.setCaches(options.icache, options.dcache);
+        simulator.setMulDiv(options.muldiv);
+        simulator.setWindow(options.window);
+        simulator.setProfile(!options.profileFile.empty() || !options.foldedFile.empty());
+        simulator.loadProgramFromFile(options.inputFile);
+        if (!options.loadCheckpoint.empty()) {
+            simulator.loadCheckpoint(options.loadCheckpoint);
+        }
+        if (options.fastForward || options.untilPc != NO_STOP_PC) {
+            uint64_t limit = options.fastForward ? options.fastForward : UINT64_MAX;
+            uint64_t executed = simulator.fastForward(limit, options.untilPc);
+            std::cout << "Fast-forwarded " << executed << " instructions to PC 0x" << std::hex
+                      << simulator.currentPc() << std::dec << "." << std::endl;
+        }
+        if (!options.streamFile.empty()) {
+            simulator.streamTo(options.streamFile);
+        } else if (!options.traceFile.empty()) {
+            simulator.traceTo(options.traceFile);
+        } else if (options.summary) {
+            simulator.discardHistory();
+        }
+        simulator.runSimulation(options.cycles);
+        if (!options.saveCheckpoint.empty()) {
+            simulator.saveCheckpoint(options.saveCheckpoint);
+        }
+        if (options.summary) {
+            std::cout << "Simulated " << simulator.simulatedCycles() << " cycles, retired "
+                      << simulator.retiredInstructions() << " instructions." << std::endl;
+        } else if (options.streamFile.empty() && options.traceFile.empty()) {
+            simulator.displayPipeline();
+        }
+        if (!options.statsFile.empty()) {
+            writeReport(options.statsFile, "stats", [&](std::ostream& out) { simulator.writeCounters(out); });
+        }
+        if (!options.profileFile.empty()) {
+            writeReport(options.profileFile, "profile", [&](std::ostream& out) { simulator.writeProfile(out, false); });
+        }
+        if (!options.foldedFile.empty()) {
+            writeReport(options.foldedFile, "profile", [&](std::ostream& out) { simulator.writeProfile(out, true); });
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Runtime Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
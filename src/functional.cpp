@@ -0,0 +1,278 @@
+#include "functional.hpp"
+#include "syscall.hpp"
+#include <vector>
+
+namespace {
+
+// Handler numbers; the runtime maps each to a label address. The ALU,
+// load, store and branch groups are offset by the decoded aluOp, memOp or
+// branchOp. Only the register forms of the RV32M ops are ever used.
+enum Handler : uint8_t {
+    H_ALU_REG = 0,
+    H_ALU_IMM = H_ALU_REG + ALU_OP_COUNT,
+    H_LOAD = H_ALU_IMM + ALU_OP_COUNT,
+    H_STORE = H_LOAD + 5,
+    H_BRANCH = H_STORE + 3,
+    H_JAL = H_BRANCH + 6,
+    H_JALR,
+    H_ECALL,
+    H_END,  // falls out of a block that does not end in a branch or jump
+    H_COUNT
+};
+
+// Register number that takes writes to x0, so handlers never test rd.
+const uint8_t SINK_REGISTER = 32;
+const uint32_t MAX_BLOCK_LENGTH = 256;
+const uint32_t NO_BLOCK = 0xFFFFFFFF;
+
+// One instruction of a translated block with its operands pre-bound.
+struct ThreadedOp {
+    const void* handler;
+    int32_t immediate;
+    uint32_t pc;
+    uint8_t kind;
+    uint8_t rd;
+    uint8_t rs1;
+    uint8_t rs2;
+};
+
+// A basic block: `length` instructions from `start`, of which bubbles
+// (nops, fences, unknown encodings) have no op. Blocks end after a branch,
+// a jump or an ECALL and in front of an EBREAK.
+struct Block {
+    uint32_t firstOp;
+    uint32_t length;
+    uint32_t start;
+};
+
+ThreadedOp translate(const DecodedInstruction& d, uint32_t pc) {
+    ThreadedOp op{};
+    op.immediate = d.immediate;
+    op.pc = pc;
+    op.rd = d.destMask ? d.destReg : SINK_REGISTER;
+    op.rs1 = d.has(DEC_USES_RS1) ? d.srcReg1 : 0;
+    op.rs2 = d.srcReg2;
+    switch (d.branchKind) {
+        case BRANCH_NONE:
+            if (d.system == SYSTEM_ECALL) op.kind = H_ECALL;
+            else if (d.has(DEC_MEM_READ)) op.kind = H_LOAD + d.memOp;
+            else if (d.has(DEC_MEM_WRITE)) op.kind = H_STORE + d.memOp;
+            else op.kind = (d.has(DEC_ALU_IMM) ? H_ALU_IMM : H_ALU_REG) + d.aluOp;
+            break;
+        case BRANCH_CONDITIONAL: op.kind = H_BRANCH + d.branchOp; break;
+        case BRANCH_JAL: op.kind = H_JAL; break;
+        case BRANCH_JALR: op.kind = H_JALR; break;
+    }
+    return op;
+}
+
+// Translations for one run, cached by the row of their first instruction.
+class BlockCache {
+public:
+    BlockCache(const Program& program, const void* const* handlers)
+        : program(program), handlers(handlers), blockAt(program.size(), NO_BLOCK) {}
+
+    const Block& blockFor(uint32_t row) {
+        if (blockAt[row] == NO_BLOCK) {
+            blockAt[row] = static_cast<uint32_t>(blocks.size());
+            blocks.push_back(build(row));
+        }
+        return blocks[blockAt[row]];
+    }
+
+    const ThreadedOp* opsOf(const Block& block) const { return &ops[block.firstOp]; }
+
+private:
+    const Program& program;
+    const void* const* handlers;
+    std::vector<uint32_t> blockAt;
+    std::vector<Block> blocks;
+    std::vector<ThreadedOp> ops;
+
+    Block build(uint32_t row) {
+        Block block{static_cast<uint32_t>(ops.size()), 0, program.base + row * 4};
+        bool endsInControl = false;
+        while (row < program.size() && block.length < MAX_BLOCK_LENGTH) {
+            const DecodedInstruction& d = program.instructions[row];
+            if (d.system == SYSTEM_EBREAK) break;
+            uint32_t pc = block.start + block.length * 4;
+            ++block.length;
+            ++row;
+            if (d.branchKind == BRANCH_NONE && d.has(DEC_BUBBLE)) continue;
+            ops.push_back(translate(d, pc));
+            ops.back().handler = handlers[ops.back().kind];
+            if (d.branchKind != BRANCH_NONE || d.system == SYSTEM_ECALL) {
+                endsInControl = true;
+                break;
+            }
+        }
+        if (!endsInControl) {
+            ThreadedOp end{};
+            end.kind = H_END;
+            end.handler = handlers[H_END];
+            end.pc = block.start + block.length * 4;
+            ops.push_back(end);
+        }
+        return block;
+    }
+};
+
+} // namespace
+
+uint64_t runFunctional(const Program& program, ArchState& state, SystemCalls& systemCalls,
+                       uint64_t maxInstructions, uint32_t untilPc, bool haltOnReturn) {
+    // Label addresses in Handler order
+    static const void* const handlers[H_COUNT] = {
+        &&alu_reg_add, &&alu_reg_sub, &&alu_reg_xor, &&alu_reg_and, &&alu_reg_or,
+        &&alu_reg_sll, &&alu_reg_srl, &&alu_reg_sra, &&alu_reg_slt, &&alu_reg_sltu,
+        &&alu_reg_mul, &&alu_reg_mulh, &&alu_reg_mulhsu, &&alu_reg_mulhu,
+        &&alu_reg_div, &&alu_reg_divu, &&alu_reg_rem, &&alu_reg_remu,
+        &&alu_imm_add, &&alu_imm_sub, &&alu_imm_xor, &&alu_imm_and, &&alu_imm_or,
+        &&alu_imm_sll, &&alu_imm_srl, &&alu_imm_sra, &&alu_imm_slt, &&alu_imm_sltu,
+        &&alu_imm_mul, &&alu_imm_mulh, &&alu_imm_mulhsu, &&alu_imm_mulhu,
+        &&alu_imm_div, &&alu_imm_divu, &&alu_imm_rem, &&alu_imm_remu,
+        &&load_byte, &&load_half, &&load_word, &&load_byte_unsigned, &&load_half_unsigned,
+        &&store_byte, &&store_half, &&store_word,
+        &&branch_eq, &&branch_ne, &&branch_lt, &&branch_ge, &&branch_ltu, &&branch_geu,
+        &&jump_jal, &&jump_jalr, &&system_ecall, &&block_end,
+    };
+
+    const DecodedInstruction* code = program.instructions.data();
+    const uint32_t codeSize = static_cast<uint32_t>(program.size());
+    const uint32_t base = program.base;
+    DataMemory& memory = state.memory;
+    BlockCache cache(program, handlers);
+
+    int32_t x[SINK_REGISTER + 1];
+    for (int i = 0; i < 32; ++i) x[i] = state.registers[i];
+    uint32_t pc = state.pc;
+    uint64_t executed = 0;
+    const ThreadedOp* op = nullptr;
+
+    auto jalrTarget = [haltOnReturn](uint32_t rs1, int32_t immediate) {
+        if (haltOnReturn && rs1 == STOP_ADDRESS) return STOP_ADDRESS;  // returning from the top-level function
+        return (rs1 + immediate) & ~1U;
+    };
+
+    // Runs one instruction the slow way; used where a whole block would
+    // overshoot the instruction limit or step over `untilPc`.
+    auto step = [&](const DecodedInstruction& d) {
+        int32_t a = d.has(DEC_USES_RS1) ? x[d.srcReg1] : 0;
+        int32_t b = d.has(DEC_ALU_IMM) ? d.immediate : x[d.srcReg2];
+        uint32_t next = pc + 4;
+
+        switch (d.branchKind) {
+            case BRANCH_NONE: {
+                if (d.system == SYSTEM_ECALL) {
+                    systemCalls.call(state, x, memory, executed);
+                    break;
+                }
+                int32_t result = aluCompute(d.aluOp, a, b);
+                if (d.has(DEC_MEM_READ)) {
+                    result = memory.load(result, d.memOp);
+                } else if (d.has(DEC_MEM_WRITE)) {
+                    memory.store(result, d.memOp, x[d.srcReg2]);
+                }
+                if (d.destMask) x[d.destReg] = result;
+                break;
+            }
+            case BRANCH_CONDITIONAL:
+                if (branchTaken(d.branchOp, a, b)) next = pc + d.immediate;
+                break;
+            case BRANCH_JAL:
+                next = pc + d.immediate;
+                if (d.destMask) x[d.destReg] = pc + 4;
+                break;
+            case BRANCH_JALR:
+                next = jalrTarget(static_cast<uint32_t>(a), d.immediate);
+                if (d.destMask) x[d.destReg] = pc + 4;
+                break;
+        }
+        pc = next;
+    };
+
+#define NEXT_OP() goto *(++op)->handler
+#define ALU_HANDLERS(name, op_)                                                          \
+    alu_reg_##name: x[op->rd] = aluCompute(op_, x[op->rs1], x[op->rs2]); NEXT_OP();        \
+    alu_imm_##name: x[op->rd] = aluCompute(op_, x[op->rs1], op->immediate); NEXT_OP();
+#define LOAD_HANDLER(name, op_)                                                          \
+    load_##name: x[op->rd] = memory.load(x[op->rs1] + op->immediate, op_); NEXT_OP();
+#define STORE_HANDLER(name, op_)                                                         \
+    store_##name: memory.store(x[op->rs1] + op->immediate, op_, x[op->rs2]); NEXT_OP();
+#define BRANCH_HANDLER(name, op_)                                                        \
+    branch_##name:                                                                       \
+        pc = branchTaken(op_, x[op->rs1], x[op->rs2]) ? op->pc + op->immediate : op->pc + 4; \
+        goto block_done;
+
+    while (executed < maxInstructions && pc != untilPc && state.halt == ProgramHalt::None) {
+        uint32_t row = (pc - base) / 4;
+        if ((pc & 3) != 0 || row >= codeSize || code[row].system == SYSTEM_EBREAK) break;
+        const Block& block = cache.blockFor(row);
+        if (block.length > maxInstructions - executed || untilPc - pc < block.length * 4) {
+            step(code[row]);
+            ++executed;
+            continue;
+        }
+        executed += block.length;
+        op = cache.opsOf(block);
+        goto *op->handler;
+
+        ALU_HANDLERS(add, ALU_ADD)
+        ALU_HANDLERS(sub, ALU_SUB)
+        ALU_HANDLERS(xor, ALU_XOR)
+        ALU_HANDLERS(and, ALU_AND)
+        ALU_HANDLERS(or, ALU_OR)
+        ALU_HANDLERS(sll, ALU_SLL)
+        ALU_HANDLERS(srl, ALU_SRL)
+        ALU_HANDLERS(sra, ALU_SRA)
+        ALU_HANDLERS(slt, ALU_SLT)
+        ALU_HANDLERS(sltu, ALU_SLTU)
+        ALU_HANDLERS(mul, ALU_MUL)
+        ALU_HANDLERS(mulh, ALU_MULH)
+        ALU_HANDLERS(mulhsu, ALU_MULHSU)
+        ALU_HANDLERS(mulhu, ALU_MULHU)
+        ALU_HANDLERS(div, ALU_DIV)
+        ALU_HANDLERS(divu, ALU_DIVU)
+        ALU_HANDLERS(rem, ALU_REM)
+        ALU_HANDLERS(remu, ALU_REMU)
+        LOAD_HANDLER(byte, MEM_BYTE)
+        LOAD_HANDLER(half, MEM_HALF)
+        LOAD_HANDLER(word, MEM_WORD)
+        LOAD_HANDLER(byte_unsigned, MEM_BYTE_UNSIGNED)
+        LOAD_HANDLER(half_unsigned, MEM_HALF_UNSIGNED)
+        STORE_HANDLER(byte, MEM_BYTE)
+        STORE_HANDLER(half, MEM_HALF)
+        STORE_HANDLER(word, MEM_WORD)
+        BRANCH_HANDLER(eq, BRANCH_EQ)
+        BRANCH_HANDLER(ne, BRANCH_NE)
+        BRANCH_HANDLER(lt, BRANCH_LT)
+        BRANCH_HANDLER(ge, BRANCH_GE)
+        BRANCH_HANDLER(ltu, BRANCH_LTU)
+        BRANCH_HANDLER(geu, BRANCH_GEU)
+    jump_jal:
+        x[op->rd] = op->pc + 4;
+        pc = op->pc + op->immediate;
+        goto block_done;
+    jump_jalr:
+        pc = jalrTarget(static_cast<uint32_t>(x[op->rs1]), op->immediate);
+        x[op->rd] = op->pc + 4;
+        goto block_done;
+    system_ecall:
+        systemCalls.call(state, x, memory, executed);
+        pc = op->pc + 4;
+        goto block_done;
+    block_end:
+        pc = op->pc;
+    block_done:;
+    }
+
+#undef NEXT_OP
+#undef ALU_HANDLERS
+#undef LOAD_HANDLER
+#undef STORE_HANDLER
+#undef BRANCH_HANDLER
+
+    for (int i = 0; i < 32; ++i) state.registers[i] = x[i];
+    state.pc = pc;
+    return executed;
+}
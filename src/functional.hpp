@@ -0,0 +1,49 @@
+#ifndef FUNCTIONAL_HPP
+#define FUNCTIONAL_HPP
+
+#include "memory.hpp"
+#include "program.hpp"
+#include <cstdint>
+
+class SystemCalls;
+
+// How a program stopped itself, if it has.
+enum class ProgramHalt : uint8_t {
+    None = 0,
+    Exit,       // the exit system call
+    Breakpoint  // EBREAK
+};
+
+// Architectural state: everything an instruction can observe. The
+// pipeline runs on one of these, and the functional executor can advance
+// it first so that detailed simulation starts part way into a program.
+struct ArchState {
+    uint32_t pc = 0;
+    int32_t registers[32] = {};
+    DataMemory memory;
+    // Kept by the system call layer (see syscall.hpp)
+    uint32_t programBreak = 0;
+    ProgramHalt halt = ProgramHalt::None;
+    int32_t exitCode = 0;
+};
+
+// "Never stop at a particular PC" for runFunctional.
+const uint32_t NO_STOP_PC = 0xFFFFFFFF;
+// Where ra points when the program starts, for engines that halt when the
+// top-level function returns.
+const uint32_t STOP_ADDRESS = 0xFFFFFFFF;
+
+// Executes instructions of `program` on `state` with ISA semantics only,
+// no pipeline timing, and ECALLs through `systemCalls`. Stops after
+// `maxInstructions`, when the PC reaches `untilPc`, when the PC leaves the
+// program, after the program exits, or in front of an EBREAK, which is
+// left for the pipeline. Returns how many instructions ran. With
+// `haltOnReturn` a JALR through STOP_ADDRESS goes there, as it does in
+// the pipelines that halt on return.
+// Each basic block is translated on first use into a direct-threaded list
+// of handlers with their operands bound, using the same aluCompute,
+// branchTaken and DataMemory semantics as the pipeline.
+uint64_t runFunctional(const Program& program, ArchState& state, SystemCalls& systemCalls,
+                       uint64_t maxInstructions, uint32_t untilPc = NO_STOP_PC, bool haltOnReturn = false);
+
+#endif
@@ -0,0 +1,56 @@
+#include "history.hpp"
+#include <algorithm>
+
+const char* stageName(Stage stage) {
+    switch (stage) {
+        case Stage::IF: return "IF";
+        case Stage::ID: return "ID";
+        case Stage::EX: return "EX";
+        case Stage::MEM: return "MEM";
+        case Stage::WB: return "WB";
+        case Stage::Stall: return "-";
+        default: return " ";
+    }
+}
+
+void PipelineHistory::reset(size_t rowCount, uint32_t base, const DiagramWindow& window) {
+    fromCycle = window.fromCycle - 1;
+    endCycle = window.toCycle;
+    // Rows of the instructions whose address is in [fromPc, toPc]
+    firstRow = window.fromPc <= base ? 0 : (static_cast<uint64_t>(window.fromPc) - base + 3) / 4;
+    size_t endRow = window.toPc < base ? 0 : std::min<size_t>((window.toPc - base) / 4 + 1, rowCount);
+    rows.assign(endRow > firstRow ? endRow - firstRow : 0, {});
+}
+
+void PipelineHistory::write(std::ostream& out, const std::vector<std::string>& labels,
+                            uint32_t cycles, const DiagramStyle& style) const {
+    std::string line;
+    uint32_t lastCycle = std::min(cycles, endCycle);
+    for (size_t row = 0; row < rows.size(); ++row) {
+        const auto& events = rows[row];
+        if (style.skipIdleRows && events.empty()) continue;
+
+        line.assign(labels[firstRow + row]);
+        auto next = events.begin();
+        for (uint32_t cycle = fromCycle; cycle < lastCycle; ++cycle) {
+            line += ';';
+            if (next != events.end() && next->cycle == cycle) {
+                if (next->stage == Stage::Stall) {
+                    line += style.stall;
+                } else if (next->stage == Stage::Empty) {
+                    line += style.empty;
+                } else {
+                    line += stageName(next->stage);
+                    if (next->part) line += static_cast<char>('0' + next->part);
+                    if (next->part && style.slots) line += '.';
+                    if (style.slots) line += static_cast<char>('0' + next->slot);
+                }
+                ++next;
+            } else {
+                line += style.empty;
+            }
+        }
+        line += '\n';
+        out.write(line.data(), line.size());
+    }
+}
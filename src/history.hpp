@@ -0,0 +1,97 @@
+#ifndef HISTORY_HPP
+#define HISTORY_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One-byte code for what an instruction did in a given cycle.
+enum class Stage : uint8_t {
+    Empty = 0,
+    IF,
+    ID,
+    EX,
+    MEM,
+    WB,
+    Stall
+};
+
+const char* stageName(Stage stage);
+
+// Most instructions a wide pipeline moves through one stage per cycle.
+const int MAX_ISSUE_WIDTH = 8;
+// Most cycles a split stage of the superscalar engine can take.
+const int MAX_SUBSTAGES = 4;
+
+struct StageEvent {
+    uint32_t cycle;  // zero-based
+    Stage stage;
+    uint8_t slot;    // position within a wide pipeline's stage, else 0
+    uint8_t part;    // sub-stage of a split stage, from 1; 0 when not split
+};
+
+// Part of a run the diagram shows: cycles numbered from 1 as the run's
+// diagram counts them, and instruction addresses; both ranges inclusive.
+struct DiagramWindow {
+    uint32_t fromCycle = 1;
+    uint32_t toCycle = UINT32_MAX;
+    uint32_t fromPc = 0;
+    uint32_t toPc = UINT32_MAX;
+
+    bool isDefault() const {
+        return fromCycle == 1 && toCycle == UINT32_MAX && fromPc == 0 && toPc == UINT32_MAX;
+    }
+};
+
+// How a history is rendered as the semicolon-separated diagram.
+struct DiagramStyle {
+    char empty;         // glyph for a cycle with nothing recorded
+    char stall;         // glyph for Stage::Stall
+    bool skipIdleRows;  // omit instructions that never entered the pipeline
+    bool slots;         // suffix each stage with its slot, e.g. EX1, or EX2.1
+                        // in sub-stage EX2
+};
+
+// Per-instruction stage history stored as a sparse list of events, so
+// memory grows with what actually happened rather than with
+// instructions x cycles. Text is only produced when the diagram is written.
+// Only the rows and cycles of the window are kept, so a slice of a long run
+// costs memory for that slice alone.
+class PipelineHistory {
+public:
+    // A table for `rowCount` instructions, the first at address `base`.
+    void reset(size_t rowCount, uint32_t base = 0, const DiagramWindow& window = DiagramWindow());
+    size_t rowCount() const { return rows.size(); }
+
+    // Records `stage` for `row` in `cycle`, a zero-based diagram column.
+    // Cycles must be recorded in non-decreasing order per row; a second
+    // record in the same cycle replaces the first. Rows and cycles outside
+    // the window are ignored.
+    void record(size_t row, uint32_t cycle, Stage stage, uint8_t slot = 0, uint8_t part = 0) {
+        if (cycle < fromCycle || cycle >= endCycle || row < firstRow) return;
+        row -= firstRow;
+        if (row >= rows.size()) return;
+        auto& events = rows[row];
+        if (!events.empty() && events.back().cycle == cycle) {
+            events.back().stage = stage;
+            events.back().slot = slot;
+            events.back().part = part;
+        } else {
+            events.push_back({cycle, stage, slot, part});
+        }
+    }
+
+    // The columns of the window among the first `cycles`, one line per
+    // kept row; `labels` has one entry per row of the whole table.
+    void write(std::ostream& out, const std::vector<std::string>& labels,
+               uint32_t cycles, const DiagramStyle& style) const;
+
+private:
+    std::vector<std::vector<StageEvent>> rows;  // from firstRow
+    size_t firstRow = 0;
+    uint32_t fromCycle = 0;
+    uint32_t endCycle = UINT32_MAX;  // exclusive
+};
+
+#endif
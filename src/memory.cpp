@@ -0,0 +1,71 @@
+#include "memory.hpp"
+#include <algorithm>
+
+DataMemory::DataMemory() = default;
+
+uint8_t* DataMemory::findPage(uint32_t pageNumber) const {
+    const auto& table = directory[pageNumber >> TABLE_BITS];
+    if (!table) return nullptr;
+    uint8_t* page = table->pages[pageNumber & ((1u << TABLE_BITS) - 1)].get();
+    if (page) {
+        cachedPageNumber = pageNumber;
+        cachedPage = page;
+    }
+    return page;
+}
+
+uint8_t* DataMemory::allocatePage(uint32_t pageNumber) {
+    uint8_t* page = findPage(pageNumber);
+    if (page) return page;
+
+    auto& table = directory[pageNumber >> TABLE_BITS];
+    if (!table) table = std::make_unique<PageTable>();
+    auto& slot = table->pages[pageNumber & ((1u << TABLE_BITS) - 1)];
+    slot = std::make_unique<uint8_t[]>(PAGE_SIZE); // zero-initialised
+    ++pageCount;
+
+    cachedPageNumber = pageNumber;
+    cachedPage = slot.get();
+    return cachedPage;
+}
+
+// Handles cache misses and accesses that straddle a page boundary.
+void DataMemory::readSlow(uint32_t address, void* out, uint32_t size) const {
+    uint8_t* bytes = static_cast<uint8_t*>(out);
+    while (size > 0) {
+        uint32_t offset = address & (PAGE_SIZE - 1);
+        uint32_t chunk = std::min(size, PAGE_SIZE - offset);
+        const uint8_t* page = findPage(address >> PAGE_BITS);
+        if (page) {
+            std::memcpy(bytes, page + offset, chunk);
+        } else {
+            std::memset(bytes, 0, chunk);
+        }
+        bytes += chunk;
+        address += chunk;
+        size -= chunk;
+    }
+}
+
+void DataMemory::writeSlow(uint32_t address, const void* in, uint32_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(in);
+    while (size > 0) {
+        uint32_t offset = address & (PAGE_SIZE - 1);
+        uint32_t chunk = std::min(size, PAGE_SIZE - offset);
+        std::memcpy(allocatePage(address >> PAGE_BITS) + offset, bytes, chunk);
+        bytes += chunk;
+        address += chunk;
+        size -= chunk;
+    }
+}
+
+void DataMemory::writePage(uint32_t pageNumber, const uint8_t* bytes) {
+    std::memcpy(allocatePage(pageNumber), bytes, PAGE_SIZE);
+}
+
+void DataMemory::clear() {
+    for (auto& table : directory) table.reset();
+    pageCount = 0;
+    cachedPageNumber = 0xFFFFFFFF;
+    cachedPage = nullptr;
+}
@@ -0,0 +1,131 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include "decoder.hpp"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// Sparse byte-addressable little-endian data memory covering the full
+// 32-bit address space. 4 KiB pages are allocated on first write through a
+// two-level page table; reads of untouched memory return zero without
+// allocating. The most recently used page is cached so that streaming
+// loads and stores skip the table walk entirely.
+class DataMemory {
+public:
+    static constexpr uint32_t PAGE_BITS = 12;
+    static constexpr uint32_t PAGE_SIZE = 1u << PAGE_BITS;
+
+    DataMemory();
+
+    uint8_t load8(uint32_t address) const;
+    uint16_t load16(uint32_t address) const;
+    uint32_t load32(uint32_t address) const;
+    void store8(uint32_t address, uint8_t value);
+    void store16(uint32_t address, uint16_t value);
+    void store32(uint32_t address, uint32_t value);
+
+    // Load/store with the width and extension given by a decoded memOp.
+    int32_t load(uint32_t address, uint8_t memOp) const;
+    void store(uint32_t address, uint8_t memOp, uint32_t value);
+
+    // Copies `length` bytes to `address` onwards, e.g. a program segment.
+    void writeBytes(uint32_t address, const uint8_t* bytes, uint32_t length) {
+        writeSlow(address, bytes, length);
+    }
+    // Copies `length` bytes from `address` onwards; untouched memory reads
+    // as zero.
+    void readBytes(uint32_t address, uint8_t* bytes, uint32_t length) const {
+        readSlow(address, bytes, length);
+    }
+
+    void clear();
+    size_t allocatedPages() const { return pageCount; }
+
+    // Visits every allocated page in address order as fn(pageNumber, bytes);
+    // writePage() installs a whole page. Used for checkpoints.
+    template <typename Fn>
+    void forEachPage(Fn&& fn) const;
+    void writePage(uint32_t pageNumber, const uint8_t* bytes);
+
+private:
+    static constexpr uint32_t DIRECTORY_BITS = 10;
+    static constexpr uint32_t TABLE_BITS = 32 - PAGE_BITS - DIRECTORY_BITS;
+
+    struct PageTable {
+        std::unique_ptr<uint8_t[]> pages[1u << TABLE_BITS];
+    };
+
+    std::unique_ptr<PageTable> directory[1u << DIRECTORY_BITS];
+    size_t pageCount = 0;
+
+    // One-entry page cache; only ever points at an allocated page.
+    mutable uint32_t cachedPageNumber = 0xFFFFFFFF;
+    mutable uint8_t* cachedPage = nullptr;
+
+    uint8_t* findPage(uint32_t pageNumber) const;
+    uint8_t* allocatePage(uint32_t pageNumber);
+    void readSlow(uint32_t address, void* out, uint32_t size) const;
+    void writeSlow(uint32_t address, const void* in, uint32_t size);
+
+    template <typename T>
+    T read(uint32_t address) const {
+        uint32_t offset = address & (PAGE_SIZE - 1);
+        if ((address >> PAGE_BITS) == cachedPageNumber && offset + sizeof(T) <= PAGE_SIZE) {
+            T value;
+            std::memcpy(&value, cachedPage + offset, sizeof(T));
+            return value;
+        }
+        T value;
+        readSlow(address, &value, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void write(uint32_t address, T value) {
+        uint32_t offset = address & (PAGE_SIZE - 1);
+        if ((address >> PAGE_BITS) == cachedPageNumber && offset + sizeof(T) <= PAGE_SIZE) {
+            std::memcpy(cachedPage + offset, &value, sizeof(T));
+            return;
+        }
+        writeSlow(address, &value, sizeof(T));
+    }
+};
+
+template <typename Fn>
+void DataMemory::forEachPage(Fn&& fn) const {
+    for (uint32_t high = 0; high < (1u << DIRECTORY_BITS); ++high) {
+        const auto& table = directory[high];
+        if (!table) continue;
+        for (uint32_t low = 0; low < (1u << TABLE_BITS); ++low) {
+            if (table->pages[low]) fn((high << TABLE_BITS) | low, table->pages[low].get());
+        }
+    }
+}
+
+inline uint8_t DataMemory::load8(uint32_t address) const { return read<uint8_t>(address); }
+inline uint16_t DataMemory::load16(uint32_t address) const { return read<uint16_t>(address); }
+inline uint32_t DataMemory::load32(uint32_t address) const { return read<uint32_t>(address); }
+inline void DataMemory::store8(uint32_t address, uint8_t value) { write(address, value); }
+inline void DataMemory::store16(uint32_t address, uint16_t value) { write(address, value); }
+inline void DataMemory::store32(uint32_t address, uint32_t value) { write(address, value); }
+
+inline int32_t DataMemory::load(uint32_t address, uint8_t memOp) const {
+    switch (memOp) {
+        case MEM_BYTE: return (int8_t)load8(address);
+        case MEM_HALF: return (int16_t)load16(address);
+        case MEM_BYTE_UNSIGNED: return load8(address);
+        case MEM_HALF_UNSIGNED: return load16(address);
+        default: return (int32_t)load32(address);
+    }
+}
+
+inline void DataMemory::store(uint32_t address, uint8_t memOp, uint32_t value) {
+    switch (memOp) {
+        case MEM_BYTE: store8(address, value & 0xFF); break;
+        case MEM_HALF: store16(address, value & 0xFFFF); break;
+        default: store32(address, value);
+    }
+}
+
+#endif
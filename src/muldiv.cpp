@@ -0,0 +1,96 @@
+#include "muldiv.hpp"
+#include "decoder.hpp"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+static bool parseLatency(const std::string& text, uint32_t& value) {
+    try {
+        size_t used = 0;
+        unsigned long number = std::stoul(text, &used, 10);
+        if (used != text.size() || number == 0 || number > 1000000) return false;
+        value = static_cast<uint32_t>(number);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool parseMulDivConfig(const std::string& spec, MulDivConfig& config, std::string& error) {
+    if (spec == "default") return true;
+
+    std::stringstream fields(spec);
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+        size_t equals = field.find('=');
+        std::string key = field.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : field.substr(equals + 1);
+        bool ok = true;
+        if (key == "mul") ok = parseLatency(value, config.mulLatency);
+        else if (key == "div") ok = parseLatency(value, config.divLatency);
+        else if (key == "mulpipe" && (value == "yes" || value == "no")) config.mulPipelined = value == "yes";
+        else if (key == "early" && (value == "yes" || value == "no")) config.divEarlyOut = value == "yes";
+        else ok = false;
+        if (!ok) {
+            error = "Invalid multiply/divide setting '" + field + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool isDivide(uint8_t aluOp) {
+    return aluOp >= ALU_DIV;
+}
+
+void MulDivUnit::configure(const MulDivConfig& settings) {
+    if (settings.mulLatency == 0 || settings.divLatency == 0) {
+        throw std::invalid_argument("Multiply and divide latencies must be at least 1");
+    }
+    config = settings;
+    multiplierFreeAt = 0;
+    dividerFreeAt = 0;
+}
+
+int MulDivUnit::acceptCycle(uint8_t aluOp) const {
+    return isDivide(aluOp) ? dividerFreeAt : multiplierFreeAt;
+}
+
+uint32_t MulDivUnit::issue(uint8_t aluOp, int32_t dividend, int cycle) {
+    if (!isDivide(aluOp)) {
+        multiplierFreeAt = cycle + (config.mulPipelined ? 1 : static_cast<int>(config.mulLatency));
+        return config.mulLatency;
+    }
+    uint32_t latency = config.divLatency;
+    if (config.divEarlyOut) {
+        // Only the significant bits of the dividend's magnitude are iterated over
+        bool isSigned = aluOp == ALU_DIV || aluOp == ALU_REM;
+        uint32_t magnitude = static_cast<uint32_t>(dividend);
+        if (isSigned && dividend < 0) magnitude = 0u - magnitude;
+        uint32_t bits = 0;
+        while (bits < 32 && (magnitude >> bits) != 0) ++bits;
+        latency = std::max<uint32_t>(1, (static_cast<uint64_t>(config.divLatency) * bits + 31) / 32);
+    }
+    dividerFreeAt = cycle + static_cast<int>(latency);
+    return latency;
+}
+
+void MulDivUnit::save(CheckpointWriter& out) const {
+    out.u32(config.mulLatency);
+    out.u32(config.divLatency);
+    out.u8(static_cast<uint8_t>(config.mulPipelined | (config.divEarlyOut << 1)));
+    out.u64(static_cast<uint64_t>(static_cast<int64_t>(multiplierFreeAt)));
+    out.u64(static_cast<uint64_t>(static_cast<int64_t>(dividerFreeAt)));
+}
+
+void MulDivUnit::load(CheckpointReader& in) {
+    uint32_t mulLatency = in.u32();
+    uint32_t divLatency = in.u32();
+    uint8_t flags = in.u8();
+    if (mulLatency != config.mulLatency || divLatency != config.divLatency ||
+        (flags & 1) != config.mulPipelined || ((flags >> 1) & 1) != config.divEarlyOut) {
+        throw std::runtime_error("Checkpoint was taken with a different multiply/divide configuration");
+    }
+    multiplierFreeAt = static_cast<int>(static_cast<int64_t>(in.u64()));
+    dividerFreeAt = static_cast<int>(static_cast<int64_t>(in.u64()));
+}
@@ -0,0 +1,47 @@
+#ifndef MULDIV_HPP
+#define MULDIV_HPP
+
+#include "checkpoint.hpp"
+#include <cstdint>
+#include <string>
+
+// Timing of the M-extension unit in EX. A latency is the number of cycles
+// from entering EX until a dependent instruction can execute with the
+// result forwarded, so a latency of 1 times like an ordinary ALU op.
+struct MulDivConfig {
+    uint32_t mulLatency = 3;
+    uint32_t divLatency = 32;    // iterative: one quotient bit per cycle
+    bool mulPipelined = true;    // accepts a new multiply every cycle
+    bool divEarlyOut = false;    // skips the dividend's leading zero bits
+};
+
+// Parses "key=value,..." with keys mul, div (latencies), mulpipe (yes|no)
+// and early (yes|no); "default" keeps every default. Returns false with
+// `error` set on bad input.
+bool parseMulDivConfig(const std::string& spec, MulDivConfig& config, std::string& error);
+
+// Occupancy of the multiplier and the divider. Results are computed when
+// an instruction enters EX and travel down the pipeline as usual; the unit
+// only decides when they may be consumed and when it can take the next
+// operation.
+class MulDivUnit {
+public:
+    void configure(const MulDivConfig& settings);  // throws std::invalid_argument
+    const MulDivConfig& settings() const { return config; }
+
+    // First cycle in which an instruction with `aluOp` can enter EX.
+    int acceptCycle(uint8_t aluOp) const;
+
+    // Starts `aluOp` in EX in `cycle` and returns its result latency.
+    uint32_t issue(uint8_t aluOp, int32_t dividend, int cycle);
+
+    void save(CheckpointWriter& out) const;
+    void load(CheckpointReader& in);
+
+private:
+    MulDivConfig config;
+    int multiplierFreeAt = 0;
+    int dividerFreeAt = 0;
+};
+
+#endif
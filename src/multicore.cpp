@@ -0,0 +1,185 @@
+#include "processor.hpp"
+#include "options.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs several copies of one pipeline on a shared, coherent data memory:
+//
+//     multicore <inputfile> <cyclecount> [--cores <n>] [--quantum <cycles>]
+//               [--coherence msi|mesi] [--engine <name>] [options]
+//
+// Every core runs the same program (SPMD) with a0 set to its core number
+// and a stack of its own. Each core has private L1s (the D-cache is on
+// even without --dcache) and runs on its own host thread. The threads
+// meet at a barrier every `quantum` cycles, so no core gets more than a
+// quantum ahead of the others. Accesses to shared data from different
+// cores within a quantum are ordered by the host, so a program whose cores
+// communicate through memory can time differently from run to run; cores
+// that only share read-only data or are on one host thread are exact.
+// Prints one summary line per core and the coherence traffic; --stats
+// writes every core's counters.
+
+static const int DEFAULT_CORES = 2;
+static const int DEFAULT_QUANTUM = 1000;
+static const uint32_t STACK_TOP = 0x7ffffff0;
+static const uint32_t STACK_STRIDE = 0x100000;  // 1 MiB of stack per core
+
+// Barrier for a fixed group of threads that meet over and over.
+class QuantumBarrier {
+public:
+    explicit QuantumBarrier(int threads) : threads(threads) {}
+
+    void arriveAndWait() {
+        std::unique_lock<std::mutex> guard(lock);
+        uint64_t arrivedIn = generation;
+        if (++waiting == threads) {
+            waiting = 0;
+            ++generation;
+            released.notify_all();
+            return;
+        }
+        released.wait(guard, [&] { return generation != arrivedIn; });
+    }
+
+private:
+    std::mutex lock;
+    std::condition_variable released;
+    int threads;
+    int waiting = 0;
+    uint64_t generation = 0;
+};
+
+template <typename Policy>
+static int runCores(const SimOptions& options) {
+    int coreCount = options.cores ? options.cores : DEFAULT_CORES;
+    int quantum = options.quantum ? options.quantum : DEFAULT_QUANTUM;
+    CoherenceProtocol protocol = CoherenceProtocol::MESI;
+    if (!options.coherence.empty()) parseCoherenceProtocol(options.coherence, protocol);
+    CacheConfig dcache = options.dcache;
+    dcache.enabled = true;
+
+    SharedMemory memory(protocol);
+    std::vector<std::unique_ptr<Processor<Policy>>> cores;
+    std::vector<std::ostringstream> messages(coreCount);
+    try {
+        if (!dcache.writeBack || !dcache.writeAllocate) {
+            throw std::invalid_argument("Coherence needs a write-back, write-allocate D-cache");
+        }
+        for (int id = 0; id < coreCount; ++id) {
+            auto core = std::make_unique<Processor<Policy>>(options.depth);
+            core->setOutput(messages[id]);
+            core->setPredictor(options.predictor);
+            core->setCaches(options.icache, dcache);
+            core->setMulDiv(options.muldiv);
+            core->attachSharedMemory(memory, id);
+            core->loadProgramFromFile(options.inputFile);
+            core->setRegister(2, static_cast<int32_t>(STACK_TOP - id * STACK_STRIDE));  // sp
+            core->setRegister(10, id);                                                   // a0
+            core->discardHistory();
+            core->startRun(options.cycles);
+            cores.push_back(std::move(core));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Runtime Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // A core that fails keeps meeting the barrier so the others can finish
+    std::vector<std::string> errors(coreCount);
+    QuantumBarrier barrier(coreCount);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int id = 0; id < coreCount; ++id) {
+        threads.emplace_back([&, id] {
+            for (int end = 0; end < options.cycles;) {
+                end = end > options.cycles - quantum ? options.cycles : end + quantum;
+                if (errors[id].empty()) {
+                    try {
+                        cores[id]->runUntil(end);
+                    } catch (const std::exception& e) {
+                        errors[id] = e.what();
+                    }
+                }
+                barrier.arriveAndWait();
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int failed = 0;
+    for (int id = 0; id < coreCount; ++id) {
+        Processor<Policy>& core = *cores[id];
+        core.finishRun();
+        std::string line;
+        std::istringstream lines(messages[id].str());
+        while (std::getline(lines, line)) std::cout << "Core " << id << ": " << line << std::endl;
+        if (!errors[id].empty()) {
+            std::cerr << "Runtime Error: core " << id << ": " << errors[id] << std::endl;
+            ++failed;
+        }
+        std::cout << "Core " << id << ": simulated " << core.simulatedCycles() << " cycles, retired "
+                  << core.retiredInstructions() << " instructions." << std::endl;
+    }
+    CoherenceStats traffic = memory.statistics();
+    std::cout << "Coherence (" << coherenceName(protocol) << "): " << traffic.readMisses << " read misses, "
+              << traffic.writeMisses << " write misses, " << traffic.upgrades << " upgrades, "
+              << traffic.invalidations << " invalidations, " << traffic.interventions << " interventions, "
+              << traffic.writebacks << " writebacks." << std::endl;
+    std::cerr << coreCount << " cores on " << coreCount << " host threads, quantum " << quantum << ", "
+              << seconds << " s wall" << std::endl;
+
+    if (!options.statsFile.empty()) {
+        std::ofstream file;
+        if (options.statsFile != "-") {
+            file.open(options.statsFile);
+            if (!file.is_open()) {
+                std::cerr << "Runtime Error: Could not open stats file: " << options.statsFile << std::endl;
+                return 1;
+            }
+        }
+        std::ostream& out = options.statsFile == "-" ? std::cout : file;
+        out << "{\n\"quantum\": " << quantum << ",\n\"coherence\": ";
+        traffic.writeJson(out, protocol);
+        out << ",\n\"cores\": [\n";
+        for (int id = 0; id < coreCount; ++id) {
+            if (id) out << ",\n";
+            cores[id]->writeCounters(out);
+        }
+        out << "]\n}\n";
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    SimOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    if (const char* option = foreignOption(options, "multicore")) {
+        std::cerr << "Error: " << option << " is not supported by multicore." << std::endl;
+        return 1;
+    }
+    if (!options.streamFile.empty() || !options.traceFile.empty() || !options.loadCheckpoint.empty() ||
+        !options.saveCheckpoint.empty() || options.fastForward || options.untilPc != NO_STOP_PC) {
+        std::cerr << "Error: multicore does not support --stream, --trace, checkpoints or fast-forwarding."
+                  << std::endl;
+        return 1;
+    }
+
+    std::string engine = options.engine.empty() ? ForwardingPolicy::name : options.engine;
+    if (engine == ForwardingPolicy::name) return runCores<ForwardingPolicy>(options);
+    if (engine == NoForwardingPolicy::name) return runCores<NoForwardingPolicy>(options);
+    if (engine == NoForwardingDecodeBranchPolicy::name) return runCores<NoForwardingDecodeBranchPolicy>(options);
+    std::cerr << "Error: Unknown engine '" << engine << "'; use forward, noforward or noforward_id." << std::endl;
+    return 1;
+}
@@ -0,0 +1,5 @@
+#include "processor.hpp"
+
+int main(int argc, char* argv[]) {
+    return runSimulator<NoForwardingDecodeBranchPolicy>(argc, argv);
+}
@@ -0,0 +1,253 @@
+#include "options.hpp"
+#include "history.hpp"
+#include "coherence.hpp"
+#include "functional.hpp"
+#include <iostream>
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <inputfile> <cyclecount> [--stream <file>] [--trace <file>]"
+              << " [--from-cycle <n>] [--to-cycle <n>] [--from-pc <address>] [--to-pc <address>]"
+              << " [--profile <file>] [--profile-folded <file>]"
+              << " [--fast-forward <instructions>] [--until-pc <address>]"
+              << " [--load-checkpoint <file>] [--save-checkpoint <file>] [--summary]"
+              << " [--stats <file>] [--predictor none|static|1bit|2bit|gshare|tournament]"
+              << " [--predictor-bits <n>] [--btb <entries>] [--btb-ways <n>]"
+              << " [--icache <spec>] [--dcache <spec>] [--muldiv <spec>]"
+              << " [--width <n>] [--mem-ports <n>] [--depth <spec>] [--cores <n>] [--quantum <cycles>]"
+              << " [--coherence msi|mesi] [--engine forward|noforward|noforward_id]" << std::endl;
+}
+
+bool parseOptions(int argc, char* argv[], SimOptions& options) {
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stream" || arg == "--trace" || arg == "--stats" || arg == "--profile" ||
+            arg == "--profile-folded") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a file name (or - for stdout)." << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            std::string& file = arg == "--stream"    ? options.streamFile
+                                : arg == "--trace"     ? options.traceFile
+                                : arg == "--stats"     ? options.statsFile
+                                : arg == "--profile"   ? options.profileFile
+                                                       : options.foldedFile;
+            file = argv[++i];
+        } else if (arg == "--summary") {
+            options.summary = true;
+        } else if (arg == "--load-checkpoint" || arg == "--save-checkpoint") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a file name." << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            (arg == "--load-checkpoint" ? options.loadCheckpoint : options.saveCheckpoint) = argv[++i];
+        } else if (arg == "--icache" || arg == "--dcache") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a cache spec, e.g. size=4k,ways=2,line=32,miss=10"
+                          << " (or default)." << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            std::string error;
+            if (!parseCacheConfig(argv[++i], arg == "--icache" ? options.icache : options.dcache, error)) {
+                std::cerr << "Error: " << error << " for " << arg << "." << std::endl;
+                return false;
+            }
+        } else if (arg == "--muldiv") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --muldiv needs a spec, e.g. mul=3,div=32,mulpipe=yes (or default)."
+                          << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            std::string error;
+            if (!parseMulDivConfig(argv[++i], options.muldiv, error)) {
+                std::cerr << "Error: " << error << " for --muldiv." << std::endl;
+                return false;
+            }
+        } else if (arg == "--depth") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --depth needs a spec, e.g. if=2,ex=2,mem=3,load=2 (or default)." << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            std::string error;
+            if (!parseDepthConfig(argv[++i], options.depth, error)) {
+                std::cerr << "Error: " << error << " for --depth." << std::endl;
+                return false;
+            }
+        } else if (arg == "--predictor") {
+            if (i + 1 >= argc || !parsePredictorKind(argv[i + 1], options.predictor.kind)) {
+                std::cerr << "Error: --predictor needs one of none, static, 1bit, 2bit, gshare, tournament."
+                          << std::endl;
+                return false;
+            }
+            ++i;
+        } else if (arg == "--predictor-bits" || arg == "--btb" || arg == "--btb-ways") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a value." << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            std::string value = argv[++i];
+            try {
+                int number = std::stoi(value);
+                if (number <= 0) throw std::invalid_argument(value);
+                if (arg == "--predictor-bits") options.predictor.indexBits = number;
+                else if (arg == "--btb") options.predictor.btbEntries = number;
+                else options.predictor.btbWays = number;
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value '" << value << "' for " << arg << "." << std::endl;
+                return false;
+            }
+        } else if (arg == "--width" || arg == "--mem-ports") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a value." << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            std::string value = argv[++i];
+            try {
+                int number = std::stoi(value);
+                if (number <= 0 || number > MAX_ISSUE_WIDTH) throw std::invalid_argument(value);
+                (arg == "--width" ? options.issueWidth : options.memoryPorts) = number;
+            } catch (const std::exception&) {
+                std::cerr << "Error: " << arg << " must be between 1 and " << MAX_ISSUE_WIDTH << "." << std::endl;
+                return false;
+            }
+        } else if (arg == "--cores" || arg == "--quantum") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a value." << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            std::string value = argv[++i];
+            try {
+                int number = std::stoi(value);
+                if (number <= 0 || (arg == "--cores" && number > MAX_CORES)) throw std::invalid_argument(value);
+                (arg == "--cores" ? options.cores : options.quantum) = number;
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value '" << value << "' for " << arg << "." << std::endl;
+                return false;
+            }
+        } else if (arg == "--coherence") {
+            CoherenceProtocol protocol;
+            if (i + 1 >= argc || !parseCoherenceProtocol(argv[i + 1], protocol)) {
+                std::cerr << "Error: --coherence needs msi or mesi." << std::endl;
+                return false;
+            }
+            options.coherence = argv[++i];
+        } else if (arg == "--engine") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: --engine needs forward, noforward or noforward_id." << std::endl;
+                return false;
+            }
+            options.engine = argv[++i];
+        } else if (arg == "--from-cycle" || arg == "--to-cycle" || arg == "--from-pc" || arg == "--to-pc") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a value." << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            std::string value = argv[++i];
+            try {
+                bool cycle = arg == "--from-cycle" || arg == "--to-cycle";
+                unsigned long long number = std::stoull(value, nullptr, cycle ? 10 : 0);
+                if (number > UINT32_MAX || (cycle && number == 0)) throw std::invalid_argument(value);
+                if (arg == "--from-cycle") options.window.fromCycle = static_cast<uint32_t>(number);
+                else if (arg == "--to-cycle") options.window.toCycle = static_cast<uint32_t>(number);
+                else if (arg == "--from-pc") options.window.fromPc = static_cast<uint32_t>(number);
+                else options.window.toPc = static_cast<uint32_t>(number);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value '" << value << "' for " << arg << "." << std::endl;
+                return false;
+            }
+        } else if (arg == "--fast-forward" || arg == "--until-pc") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " needs a value." << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            std::string value = argv[++i];
+            try {
+                // Base 0 accepts decimal, 0x-prefixed hex and 0-prefixed octal
+                unsigned long long number = std::stoull(value, nullptr, 0);
+                if (arg == "--fast-forward") options.fastForward = number;
+                else options.untilPc = static_cast<uint32_t>(number);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value '" << value << "' for " << arg << "." << std::endl;
+                return false;
+            }
+        } else if (positional == 0) {
+            options.inputFile = arg;
+            ++positional;
+        } else if (positional == 1) {
+            try {
+                options.cycles = std::stoi(arg);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid cycle count '" << arg << "'." << std::endl;
+                return false;
+            }
+            if (options.cycles <= 0) {
+                std::cerr << "Error: Cycle count must be positive." << std::endl;
+                return false;
+            }
+            ++positional;
+        } else {
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (positional != 2) {
+        printUsage(argv[0]);
+        return false;
+    }
+    if (!options.streamFile.empty() && !options.traceFile.empty()) {
+        std::cerr << "Error: --stream and --trace cannot be combined." << std::endl;
+        return false;
+    }
+    // A checkpoint restores instructions still in the pipeline, which the
+    // functional run would step over
+    if (!options.loadCheckpoint.empty() && (options.fastForward || options.untilPc != NO_STOP_PC)) {
+        std::cerr << "Error: --fast-forward and --until-pc cannot be combined with --load-checkpoint." << std::endl;
+        return false;
+    }
+    if (options.window.fromCycle > options.window.toCycle || options.window.fromPc > options.window.toPc) {
+        std::cerr << "Error: The diagram window ends before it starts." << std::endl;
+        return false;
+    }
+    if (!options.window.isDefault() &&
+        (!options.streamFile.empty() || !options.traceFile.empty() || options.summary)) {
+        std::cerr << "Error: --from-cycle, --to-cycle, --from-pc and --to-pc select part of the diagram;"
+                  << " they cannot be combined with --stream, --trace or --summary." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+const char* foreignOption(const SimOptions& options, const std::string& binary) {
+    if (binary != "superscalar") {
+        if (options.issueWidth) return "--width";
+        if (options.memoryPorts) return "--mem-ports";
+    }
+    // Only noforward resolves branches and jumps in EX
+    bool resolvesInExecute = binary == "noforward" || (binary == "multicore" && options.engine == "noforward");
+    if (options.depth.branchLatency != 1 && !resolvesInExecute) return "--depth branch=";
+    if (binary == "multicore") {
+        // No diagram to window, and no per-core profile
+        if (!options.profileFile.empty()) return "--profile";
+        if (!options.foldedFile.empty()) return "--profile-folded";
+        if (options.window.fromCycle != 1) return "--from-cycle";
+        if (options.window.toCycle != UINT32_MAX) return "--to-cycle";
+        if (options.window.fromPc != 0) return "--from-pc";
+        if (options.window.toPc != UINT32_MAX) return "--to-pc";
+    } else {
+        if (options.cores) return "--cores";
+        if (options.quantum) return "--quantum";
+        if (!options.coherence.empty()) return "--coherence";
+        if (!options.engine.empty()) return "--engine";
+    }
+    return nullptr;
+}
@@ -0,0 +1,59 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include "predictor.hpp"
+#include "cache.hpp"
+#include "muldiv.hpp"
+#include "depth.hpp"
+#include "history.hpp"
+#include <cstdint>
+#include <string>
+
+// Command line shared by every simulator:
+//     <inputfile> <cyclecount> [--stream <file>] [--trace <file>]
+//         [--from-cycle <n>] [--to-cycle <n>] [--from-pc <address>] [--to-pc <address>]
+//         [--profile <file>] [--profile-folded <file>]
+//         [--fast-forward <instructions>] [--until-pc <address>]
+//         [--load-checkpoint <file>] [--save-checkpoint <file>] [--summary]
+//         [--stats <file>] [--predictor <kind>] [--predictor-bits <n>]
+//         [--btb <entries>] [--btb-ways <n>] [--icache <spec>] [--dcache <spec>]
+//         [--muldiv <spec>] [--width <n>] [--mem-ports <n>] [--depth <spec>]
+//         [--cores <n>] [--quantum <cycles>] [--coherence msi|mesi] [--engine <name>]
+struct SimOptions {
+    std::string inputFile;
+    int cycles = 0;
+    std::string streamFile;  // cycle-major trace instead of the final diagram
+    std::string traceFile;   // binary pipeline trace instead of the final diagram
+    DiagramWindow window;    // part of the diagram to keep
+    uint64_t fastForward = 0;          // instructions to run functionally first
+    uint32_t untilPc = 0xFFFFFFFF;     // or run functionally until this PC
+    std::string loadCheckpoint;        // start from this checkpoint
+    std::string saveCheckpoint;        // write a checkpoint after the run
+    bool summary = false;              // cycle and instruction counts instead of the diagram
+    std::string statsFile;             // performance counters as JSON after the run
+    std::string profileFile;           // cycles by instruction and cause after the run
+    std::string foldedFile;            // the same as folded stacks for flame graphs
+    PredictorConfig predictor;         // fetch-side branch prediction
+    CacheConfig icache;                // L1 timing, off unless given
+    CacheConfig dcache;
+    MulDivConfig muldiv;               // RV32M latencies
+    int issueWidth = 0;                // superscalar only: instructions per stage, 0 when not given
+    int memoryPorts = 0;               // superscalar only: loads and stores issued per cycle
+    DepthConfig depth;                 // sub-stages of IF, EX and MEM
+    int cores = 0;                     // multicore only, like the three below
+    int quantum = 0;                   // cycles between the cores' barriers
+    std::string coherence;             // msi or mesi
+    std::string engine;                // pipeline of every core
+};
+
+// Fills `options` from argv. On bad input prints the problem and the usage
+// line to stderr and returns false.
+bool parseOptions(int argc, char* argv[], SimOptions& options);
+
+// The first option given that `binary` does not take, or nullptr. Most
+// options apply everywhere; a few only to "superscalar" or "multicore", and
+// the diagram window and the profile to everything but "multicore".
+// `--depth branch=` needs an engine that resolves branches in EX.
+const char* foreignOption(const SimOptions& options, const std::string& binary);
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef POLICIES_HPP
+#define POLICIES_HPP
+
+#include "history.hpp"
+
+// Compile-time descriptions of the pipelines built from Processor<Policy>.
+// Every member is constexpr, so the stage code picks its behaviour with
+// `if constexpr` and the per-cycle loop carries no policy checks.
+//
+//   forwarding       results are bypassed from EX/MEM and MEM/WB, and only
+//                    the hazards bypassing cannot cover stall; otherwise an
+//                    instruction waits in ID until its producers have
+//                    written back
+//   resolveInDecode  branches and jumps are resolved in ID and redirect
+//                    fetch in the following cycle; otherwise jumps are
+//                    resolved in EX and redirect fetch in the same cycle
+//   resolveBranches  conditional branches redirect when taken; when false
+//                    every branch is treated as not taken
+//   haltOnReturn     ra starts at STOP_ADDRESS and a jalr through a register
+//                    holding it goes there; the run ends at STOP_ADDRESS or
+//                    once the pipeline drains past the last instruction
+//   squashNops       nop, fence, system and unknown encodings leave the
+//                    pipeline in ID
+//   repeatAsStall    an instruction seen in the same stage (IF to MEM) on
+//                    consecutive cycles shows the stage name first and "-"
+//                    afterwards;
+//                    otherwise held cycles are "-" and the stage name marks
+//                    the cycle it moves on
+//   diagram          how displayPipeline() renders the history
+//   name             binary name, also recorded in checkpoints
+
+// Stall until the producer has written back; jumps redirect from EX and
+// conditional branches are never taken.
+struct NoForwardingPolicy {
+    static constexpr bool forwarding = false;
+    static constexpr bool resolveInDecode = false;
+    static constexpr bool resolveBranches = false;
+    static constexpr bool haltOnReturn = true;
+    static constexpr bool squashNops = true;
+    static constexpr bool repeatAsStall = false;
+    static constexpr DiagramStyle diagram{'-', '-', true, false};
+    static constexpr const char* name = "noforward";
+};
+
+// Full bypassing; branches and jumps are resolved in ID.
+struct ForwardingPolicy {
+    static constexpr bool forwarding = true;
+    static constexpr bool resolveInDecode = true;
+    static constexpr bool resolveBranches = true;
+    static constexpr bool haltOnReturn = false;
+    static constexpr bool squashNops = false;
+    static constexpr bool repeatAsStall = true;
+    static constexpr DiagramStyle diagram{' ', '-', false, false};
+    static constexpr const char* name = "forward";
+};
+
+// The no-forwarding pipeline with branches and jumps resolved in ID, so
+// taken branches redirect instead of running down the not-taken path.
+struct NoForwardingDecodeBranchPolicy {
+    static constexpr bool forwarding = false;
+    static constexpr bool resolveInDecode = true;
+    static constexpr bool resolveBranches = true;
+    static constexpr bool haltOnReturn = true;
+    static constexpr bool squashNops = true;
+    static constexpr bool repeatAsStall = false;
+    static constexpr DiagramStyle diagram{'-', '-', true, false};
+    static constexpr const char* name = "noforward_id";
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include "predictor.hpp"
+#include <stdexcept>
+
+static const char* const PREDICTOR_NAMES[] = {"none", "static", "1bit", "2bit", "gshare", "tournament"};
+
+const char* predictorName(PredictorKind kind) {
+    return PREDICTOR_NAMES[static_cast<int>(kind)];
+}
+
+bool parsePredictorKind(const std::string& name, PredictorKind& kind) {
+    for (int i = 0; i <= static_cast<int>(PredictorKind::Tournament); ++i) {
+        if (name == PREDICTOR_NAMES[i]) {
+            kind = static_cast<PredictorKind>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+
+// Saturating counters; a counter predicts taken in its upper half.
+class CounterTable {
+public:
+    CounterTable(unsigned indexBits, uint8_t maximum)
+        : counters(size_t(1) << indexBits, maximum / 2), mask((1u << indexBits) - 1), maximum(maximum) {}
+
+    bool predict(uint32_t index) const { return counters[index & mask] > maximum / 2; }
+    void update(uint32_t index, bool taken) {
+        uint8_t& counter = counters[index & mask];
+        if (taken && counter < maximum) ++counter;
+        else if (!taken && counter > 0) --counter;
+    }
+    void save(CheckpointWriter& out) const { out.bytes(counters.data(), counters.size()); }
+    void load(CheckpointReader& in) { in.bytes(counters.data(), counters.size()); }
+
+private:
+    std::vector<uint8_t> counters;
+    uint32_t mask;
+    uint8_t maximum;
+};
+
+class StaticPredictor : public DirectionPredictor {
+public:
+    bool predict(uint32_t pc, uint32_t target) const override { return target <= pc; }
+    void update(uint32_t, uint32_t, bool) override {}
+    void save(CheckpointWriter&) const override {}
+    void load(CheckpointReader&) override {}
+};
+
+// One counter per PC: 1-bit (last outcome) or 2-bit.
+class BimodalPredictor : public DirectionPredictor {
+public:
+    BimodalPredictor(unsigned indexBits, uint8_t maximum) : table(indexBits, maximum) {}
+    bool predict(uint32_t pc, uint32_t) const override { return table.predict(pc >> 2); }
+    void update(uint32_t pc, uint32_t, bool taken) override { table.update(pc >> 2, taken); }
+    void save(CheckpointWriter& out) const override { table.save(out); }
+    void load(CheckpointReader& in) override { table.load(in); }
+
+private:
+    CounterTable table;
+};
+
+class GsharePredictor : public DirectionPredictor {
+public:
+    explicit GsharePredictor(unsigned indexBits) : table(indexBits, 3), historyMask((1u << indexBits) - 1) {}
+    bool predict(uint32_t pc, uint32_t) const override { return table.predict((pc >> 2) ^ history); }
+    void update(uint32_t pc, uint32_t, bool taken) override {
+        table.update((pc >> 2) ^ history, taken);
+        history = ((history << 1) | (taken ? 1 : 0)) & historyMask;
+    }
+    void save(CheckpointWriter& out) const override {
+        table.save(out);
+        out.u32(history);
+    }
+    void load(CheckpointReader& in) override {
+        table.load(in);
+        history = in.u32() & historyMask;
+    }
+
+private:
+    CounterTable table;
+    uint32_t historyMask;
+    uint32_t history = 0;
+};
+
+class TournamentPredictor : public DirectionPredictor {
+public:
+    explicit TournamentPredictor(unsigned indexBits)
+        : local(indexBits, 3), global(indexBits), chooser(indexBits, 3) {}
+
+    bool predict(uint32_t pc, uint32_t target) const override {
+        return chooser.predict(pc >> 2) ? global.predict(pc, target) : local.predict(pc, target);
+    }
+    void update(uint32_t pc, uint32_t target, bool taken) override {
+        bool localCorrect = local.predict(pc, target) == taken;
+        bool globalCorrect = global.predict(pc, target) == taken;
+        if (localCorrect != globalCorrect) chooser.update(pc >> 2, globalCorrect);
+        local.update(pc, target, taken);
+        global.update(pc, target, taken);
+    }
+    void save(CheckpointWriter& out) const override {
+        local.save(out);
+        global.save(out);
+        chooser.save(out);
+    }
+    void load(CheckpointReader& in) override {
+        local.load(in);
+        global.load(in);
+        chooser.load(in);
+    }
+
+private:
+    BimodalPredictor local;
+    GsharePredictor global;
+    CounterTable chooser;  // upper half picks gshare
+};
+
+} // namespace
+
+void BranchTargetBuffer::configure(unsigned entryCount, unsigned wayCount) {
+    if (wayCount == 0 || entryCount < wayCount || entryCount % wayCount != 0) {
+        throw std::invalid_argument("BTB entries must be a multiple of its ways");
+    }
+    unsigned sets = entryCount / wayCount;
+    if ((sets & (sets - 1)) != 0) {
+        throw std::invalid_argument("BTB sets (entries / ways) must be a power of two");
+    }
+    entries.assign(entryCount, Entry());
+    ways = wayCount;
+    setMask = sets - 1;
+    useClock = 0;
+}
+
+const BranchTargetBuffer::Entry* BranchTargetBuffer::lookup(uint32_t pc) {
+    Entry* set = &entries[((pc >> 2) & setMask) * ways];
+    for (unsigned way = 0; way < ways; ++way) {
+        if (set[way].valid && set[way].pc == pc) {
+            set[way].lastUse = ++useClock;
+            return &set[way];
+        }
+    }
+    return nullptr;
+}
+
+void BranchTargetBuffer::insert(uint32_t pc, uint32_t target, bool conditional) {
+    Entry* set = &entries[((pc >> 2) & setMask) * ways];
+    Entry* victim = &set[0];
+    for (unsigned way = 0; way < ways; ++way) {
+        if (set[way].valid && set[way].pc == pc) {
+            victim = &set[way];
+            break;
+        }
+        if (!set[way].valid || (victim->valid && set[way].lastUse < victim->lastUse)) {
+            victim = &set[way];
+        }
+    }
+    *victim = {true, conditional, pc, target, ++useClock};
+}
+
+void BranchTargetBuffer::save(CheckpointWriter& out) const {
+    out.u64(useClock);
+    for (const Entry& entry : entries) {
+        out.u8(entry.valid);
+        out.u8(entry.conditional);
+        out.u32(entry.pc);
+        out.u32(entry.target);
+        out.u64(entry.lastUse);
+    }
+}
+
+void BranchTargetBuffer::load(CheckpointReader& in) {
+    useClock = in.u64();
+    for (Entry& entry : entries) {
+        entry.valid = in.u8() != 0;
+        entry.conditional = in.u8() != 0;
+        entry.pc = in.u32();
+        entry.target = in.u32();
+        entry.lastUse = in.u64();
+    }
+}
+
+void BranchPredictor::configure(const PredictorConfig& settings) {
+    if (settings.indexBits == 0 || settings.indexBits > 24) {
+        throw std::invalid_argument("Predictor index bits must be between 1 and 24");
+    }
+    config = settings;
+    direction.reset();
+    switch (config.kind) {
+        case PredictorKind::None: return;
+        case PredictorKind::Static: direction = std::make_unique<StaticPredictor>(); break;
+        case PredictorKind::OneBit: direction = std::make_unique<BimodalPredictor>(config.indexBits, 1); break;
+        case PredictorKind::TwoBit: direction = std::make_unique<BimodalPredictor>(config.indexBits, 3); break;
+        case PredictorKind::Gshare: direction = std::make_unique<GsharePredictor>(config.indexBits); break;
+        case PredictorKind::Tournament: direction = std::make_unique<TournamentPredictor>(config.indexBits); break;
+    }
+    btb.configure(config.btbEntries, config.btbWays);
+}
+
+Prediction BranchPredictor::predict(uint32_t pc, bool& btbHit) {
+    const BranchTargetBuffer::Entry* entry = btb.lookup(pc);
+    btbHit = entry != nullptr;
+    if (!entry) return Prediction();
+    bool taken = !entry->conditional || direction->predict(pc, entry->target);
+    return {taken, entry->target};
+}
+
+void BranchPredictor::update(uint32_t pc, bool conditional, bool taken, uint32_t target) {
+    if (conditional) direction->update(pc, target, taken);
+    // Not-taken branches stay out of the BTB; a miss already predicts them
+    if (taken) btb.insert(pc, target, conditional);
+}
+
+void BranchPredictor::save(CheckpointWriter& out) const {
+    out.u8(static_cast<uint8_t>(config.kind));
+    out.u32(config.indexBits);
+    out.u32(config.btbEntries);
+    out.u32(config.btbWays);
+    if (!enabled()) return;
+    direction->save(out);
+    btb.save(out);
+}
+
+void BranchPredictor::load(CheckpointReader& in) {
+    PredictorKind kind = static_cast<PredictorKind>(in.u8());
+    unsigned indexBits = in.u32();
+    unsigned btbEntries = in.u32();
+    unsigned btbWays = in.u32();
+    if (kind != config.kind || (enabled() && (indexBits != config.indexBits || btbEntries != config.btbEntries ||
+                                              btbWays != config.btbWays))) {
+        throw std::runtime_error("Checkpoint was taken with a different branch predictor");
+    }
+    if (!enabled()) return;
+    direction->load(in);
+    btb.load(in);
+}
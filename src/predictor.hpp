@@ -0,0 +1,92 @@
+#ifndef PREDICTOR_HPP
+#define PREDICTOR_HPP
+
+#include "checkpoint.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class PredictorKind : uint8_t {
+    None = 0,    // no frontend: always fetch PC + 4
+    Static,      // backward taken, forward not taken
+    OneBit,      // last outcome per PC
+    TwoBit,      // 2-bit saturating counter per PC (bimodal)
+    Gshare,      // 2-bit counters indexed by PC xor global history
+    Tournament   // bimodal and gshare with a per-PC 2-bit chooser
+};
+
+const char* predictorName(PredictorKind kind);
+bool parsePredictorKind(const std::string& name, PredictorKind& kind);
+
+struct PredictorConfig {
+    PredictorKind kind = PredictorKind::None;
+    unsigned indexBits = 10;   // log2 of each pattern table; gshare history length
+    unsigned btbEntries = 64;
+    unsigned btbWays = 4;
+};
+
+// Direction half of the frontend. Tables are updated when a branch is
+// resolved, so gshare's history only holds resolved outcomes.
+class DirectionPredictor {
+public:
+    virtual ~DirectionPredictor() = default;
+    virtual bool predict(uint32_t pc, uint32_t target) const = 0;
+    virtual void update(uint32_t pc, uint32_t target, bool taken) = 0;
+    virtual void save(CheckpointWriter& out) const = 0;
+    virtual void load(CheckpointReader& in) = 0;
+};
+
+// Set-associative branch target buffer tagged by the full PC, with LRU
+// replacement within a set.
+class BranchTargetBuffer {
+public:
+    struct Entry {
+        bool valid = false;
+        bool conditional = false;
+        uint32_t pc = 0;
+        uint32_t target = 0;
+        uint64_t lastUse = 0;
+    };
+
+    void configure(unsigned entries, unsigned ways);
+    const Entry* lookup(uint32_t pc);
+    void insert(uint32_t pc, uint32_t target, bool conditional);
+    void save(CheckpointWriter& out) const;
+    void load(CheckpointReader& in);
+
+private:
+    std::vector<Entry> entries;
+    unsigned ways = 1;
+    unsigned setMask = 0;
+    uint64_t useClock = 0;
+};
+
+struct Prediction {
+    bool taken = false;
+    uint32_t target = 0;
+};
+
+// What IF consults before choosing the next fetch address. A BTB miss
+// predicts fall-through; a hit predicts a jump taken to its last target
+// and asks the direction predictor about a conditional branch.
+class BranchPredictor {
+public:
+    void configure(const PredictorConfig& settings);  // throws std::invalid_argument
+    bool enabled() const { return config.kind != PredictorKind::None; }
+    const PredictorConfig& settings() const { return config; }
+
+    // `btbHit` is set when the BTB knew the PC.
+    Prediction predict(uint32_t pc, bool& btbHit);
+    void update(uint32_t pc, bool conditional, bool taken, uint32_t target);
+
+    void save(CheckpointWriter& out) const;
+    void load(CheckpointReader& in);  // the checkpoint must use the same configuration
+
+private:
+    PredictorConfig config;
+    BranchTargetBuffer btb;
+    std::unique_ptr<DirectionPredictor> direction;
+};
+
+#endif
@@ -1,353 +1,1003 @@
 #include "processor.hpp"
+#include "driver.hpp"
 #include <iostream>
 #include <fstream>
-#include <sstream>
-#include <iomanip>
 #include <algorithm>
+#include <stdexcept>
 
-Processor::Processor() 
-    : programCounter(0), registers(32, 0), currentCycleCount(0), maxCycleLimit(0) {
-    setupRegisters();
-    fetchToDecode.instruction = InstructionDetails(true);
-    decodeToExecute.instruction = InstructionDetails(true);
-    executeToMemory.instruction = InstructionDetails(true);
-    memoryToWriteback.instruction = InstructionDetails(true);
+static bool inFlight(const std::vector<PipelineStage>& latches) {
+    return std::any_of(latches.begin(), latches.end(), [](const PipelineStage& stage) { return stage.hasData; });
 }
 
-void Processor::setupRegisters(uint32_t stackPointer, uint32_t globalPointer) {
-    registers.assign(32, 0);
-    if (registers.size() > 1) registers[1] = STOP_ADDRESS; // ra (return address)
-    if (registers.size() > 2) registers[2] = stackPointer;  // sp
-    if (registers.size() > 3) registers[3] = globalPointer; // gp
-}
-
-void Processor::loadProgramFromFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw std::runtime_error("Could not open file: " + filename);
+template <typename Policy>
+Processor<Policy>::Processor(const DepthConfig& depth)
+    : depth(depth), fetchLatches(depth.fetchStages - 1),
+      executeToWriteback(depth.executeStages + depth.memoryStages), output(&std::cout), currentCycleCount(0),
+      maxCycleLimit(0) {
+    if constexpr (Policy::haltOnReturn) {
+        setupRegisters();
     }
+}
 
-    std::string line;
-    uint32_t address = 0;
-    programMemory.clear();
-
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        int lineNumber;
-        uint32_t machineCode;
-        std::string assembly;
-
-        if (!(ss >> lineNumber)) {
-            if (!line.empty() && line.find_first_not_of(" \t\r\n") != std::string::npos) {
-                std::cerr << "Warning: Skipping invalid line: \"" << line << "\"" << std::endl;
-            }
-            continue;
-        }
+template <typename Policy>
+void Processor<Policy>::setupRegisters(uint32_t stackPointer, uint32_t globalPointer) {
+    std::fill(std::begin(state.registers), std::end(state.registers), 0);
+    state.registers[1] = STOP_ADDRESS;  // ra (return address)
+    state.registers[2] = stackPointer;  // sp
+    state.registers[3] = globalPointer; // gp
+}
 
-        if (!(ss >> std::hex >> machineCode)) {
-            if (!line.empty() && line.find_first_not_of(" \t\r\n") != std::string::npos) {
-                std::cerr << "Warning: Skipping invalid line: \"" << line << "\"" << std::endl;
-            }
-            continue;
-        }
+template <typename Policy>
+void Processor<Policy>::loadProgramFromFile(const std::string& filename) {
+    program = loadProgram(filename);
+    DataMemory& memory = sharedMemory ? sharedMemory->data() : state.memory;
+    for (const MemorySegment& segment : program.segments) {
+        memory.writeBytes(segment.address, segment.bytes, segment.fileSize);
+    }
+    state.pc = program.entry;
+    state.programBreak = initialBreak(program);
+    if (sharedMemory) sharedMemory->setProgramBreak(state.programBreak);
+    pipelineHistory.reset(program.size(), program.base, diagramWindow);
+}
 
-        std::getline(ss, assembly);
-        assembly.erase(0, assembly.find_first_not_of(" \t"));
-        if (assembly.empty()) {
-            assembly = "NOP";
-        }
+template <typename Policy>
+void Processor<Policy>::setCaches(const CacheConfig& instruction, const CacheConfig& data) {
+    icache.configure(instruction);
+    dcache.configure(data);
+}
 
-        programMemory[address] = {machineCode, assembly};
-        address += 4;
-    }
+template <typename Policy>
+uint64_t Processor<Policy>::fastForward(uint64_t maxInstructions, uint32_t untilPc) {
+    return runFunctional(program, state, systemCalls, maxInstructions, untilPc, Policy::haltOnReturn);
+}
 
-    file.close();
-    programCounter = 0;
+template <typename Policy>
+void Processor<Policy>::runSimulation(int totalCycles) {
+    startRun(totalCycles);
+    runUntil(totalCycles);
+    finishRun();
 }
 
-void Processor::runSimulation(int totalCycles) {
+template <typename Policy>
+void Processor<Policy>::startRun(int totalCycles) {
     maxCycleLimit = totalCycles;
-    if (programMemory.empty()) {
-        std::cout << "No program loaded. Stopping." << std::endl;
+    halted = false;
+    if (program.empty()) {
+        *output << "No program loaded. Stopping." << std::endl;
         maxCycleLimit = 0;
+        halted = true;
         return;
     }
+    if (state.halt != ProgramHalt::None) {
+        *output << "Program has already stopped. Stopping." << std::endl;
+        maxCycleLimit = 0;
+        halted = true;
+        return;
+    }
+    firstCycle = currentCycleCount;
+    counters.reset(program.size(), icache.enabled(), dcache.enabled());
+    profile.reset(profiling ? program.size() : 0);
+}
 
-    for (currentCycleCount = 0; currentCycleCount < maxCycleLimit; ++currentCycleCount) {
-        if (programCounter == STOP_ADDRESS) {
-            std::cout << "Reached STOP_ADDRESS (0x" << std::hex << STOP_ADDRESS 
-                      << std::dec << ") at cycle " << currentCycleCount << "." << std::endl;
-            maxCycleLimit = currentCycleCount;
-            break;
+template <typename Policy>
+void Processor<Policy>::runUntil(int cycles) {
+    int stop = std::min(cycles, maxCycleLimit);
+    for (; !halted && currentCycleCount - firstCycle < stop; ++currentCycleCount) {
+        if constexpr (Policy::haltOnReturn) {
+            // Once the return is one latch from WB, as in the five-stage pipeline
+            bool returned = state.pc == STOP_ADDRESS && !inFlight(fetchLatches) && !fetchToDecode.hasData &&
+                            !decodeToExecute.hasData &&
+                            std::none_of(executeToWriteback.begin(), executeToWriteback.end() - 2,
+                                         [](const PipelineStage& stage) { return stage.hasData; });
+            if (returned) {
+                *output << "Reached STOP_ADDRESS (0x" << std::hex << STOP_ADDRESS
+                          << std::dec << ") at cycle " << currentCycleCount << "." << std::endl;
+                maxCycleLimit = currentCycleCount - firstCycle;
+                halted = true;
+                break;
+            }
+        }
+
+        // Cycles in which only a wait counter moves are applied in one step
+        if (int idle = idleCycles(); idle > 0) {
+            idle = std::min(idle, stop - (currentCycleCount - firstCycle));
+            skipIdleCycles(idle);
+            currentCycleCount += idle - 1;
+            continue;
         }
 
         pausePipeline = false;
+        memoryStalled = false;
+        if (cycleStream.isOpen()) cycleStream.beginCycle(currentCycleCount + 1);
         writeBackToRegisters();
         accessMemory();
         executeInstruction();
         decodeInstruction();
         fetchInstruction();
-
-        bool isPipelineEmpty = !fetchToDecode.hasData && !decodeToExecute.hasData && 
-                              !executeToMemory.hasData && !memoryToWriteback.hasData;
-        if (isPipelineEmpty) {
-            uint32_t lastAddress = programMemory.empty() ? 0 : programMemory.rbegin()->first;
-            if (programCounter > lastAddress && programCounter != STOP_ADDRESS) {
-                std::cout << "Pipeline empty and PC (0x" << std::hex << programCounter 
-                          << std::dec << ") past end. Stopping at cycle " << currentCycleCount + 1 << "." << std::endl;
-                maxCycleLimit = currentCycleCount + 1;
-                break;
+        if (cycleStream.isOpen()) cycleStream.endCycle();
+
+        bool isPipelineEmpty = !inFlight(fetchLatches) && !fetchToDecode.hasData && !decodeToExecute.hasData &&
+                               !inFlight(executeToWriteback);
+        // An exit or EBREAK stops the run once it has left the pipeline
+        if (state.halt != ProgramHalt::None && isPipelineEmpty) {
+            if (state.halt == ProgramHalt::Exit) {
+                *output << "Program exited with code " << state.exitCode;
+            } else {
+                *output << "EBREAK at 0x" << std::hex << haltAddress << std::dec;
+            }
+            *output << ". Stopping at cycle " << currentCycleCount + 1 << "." << std::endl;
+            ++currentCycleCount;  // the cycle in which it wrote back is part of the run
+            maxCycleLimit = currentCycleCount - firstCycle;
+            halted = true;
+            break;
+        }
+        if constexpr (Policy::haltOnReturn) {
+            if (isPipelineEmpty) {
+                uint32_t lastAddress = program.base + (program.size() - 1) * 4;
+                if ((state.pc < program.base || state.pc > lastAddress) && state.pc != STOP_ADDRESS) {
+                    *output << "Pipeline empty and PC (0x" << std::hex << state.pc
+                              << std::dec << ") past end. Stopping at cycle " << currentCycleCount + 1 << "." << std::endl;
+                    maxCycleLimit = currentCycleCount + 1 - firstCycle;
+                    halted = true;
+                    break;
+                }
             }
         }
     }
-    maxCycleLimit = std::min(maxCycleLimit, currentCycleCount);
 }
 
-void Processor::logStage(uint32_t address, const std::string& stageName) {
-    if (currentCycleCount >= maxCycleLimit) return;
-    auto& history = pipelineHistory[address];
-    if (history.size() <= static_cast<size_t>(currentCycleCount)) {
-        history.resize(currentCycleCount + 1, "-");
-    }
-    history[currentCycleCount] = stageName;
+template <typename Policy>
+void Processor<Policy>::finishRun() {
+    maxCycleLimit = std::min(maxCycleLimit, currentCycleCount - firstCycle);
+    counters.cycles = static_cast<uint64_t>(maxCycleLimit);
+    cycleStream.close();
+    trace.close(static_cast<uint32_t>(maxCycleLimit));
+}
+
+template <typename Policy>
+void Processor<Policy>::attachSharedMemory(SharedMemory& memory, int core) {
+    sharedMemory = &memory;
+    coreId = core;
 }
 
-void Processor::fetchInstruction() {
-    if (currentCycleCount >= maxCycleLimit) return;
-    uint32_t currentAddress = programCounter;
-    bool canFetch = programMemory.count(currentAddress) > 0;
+template <typename Policy>
+void Processor<Policy>::writeCounters(std::ostream& out) const {
+    counters.writeJson(out, Policy::name, predictorName(predictor.settings().kind), program.labels(),
+                       program.base);
+}
 
-    if (pausePipeline) {
-        if (canFetch) logStage(currentAddress, "-");
-        return;
+template <typename Policy>
+void Processor<Policy>::writeProfile(std::ostream& out, bool folded) const {
+    if (folded) profile.writeFolded(out, program);
+    else profile.writeReport(out, Policy::name, program, counters.cycles, counters.retired);
+}
+
+template <typename Policy>
+void Processor<Policy>::streamTo(const std::string& path) {
+    cycleStream.open(path, 1, depth);
+}
+
+template <typename Policy>
+void Processor<Policy>::traceTo(const std::string& path) {
+    trace.open(path, Policy::name, Policy::diagram, program.base, program.labels());
+}
+
+template <typename Policy>
+void Processor<Policy>::saveStage(CheckpointWriter& out, const PipelineStage& stage) const {
+    // The record is stored as its index into the program
+    out.u32(stage.instruction ? static_cast<uint32_t>(stage.instruction - program.instructions.data())
+                              : 0xFFFFFFFF);
+    out.u32(stage.programCounter);
+    out.u8(stage.hasData);
+    out.u32(static_cast<uint32_t>(stage.aluResult));
+    out.u32(static_cast<uint32_t>(stage.memoryData));
+    out.u8(stage.predictedTaken);
+    out.u32(stage.predictedTarget);
+    out.u8(stage.resolvedTaken);
+    out.u32(stage.resolvedTarget);
+}
+
+template <typename Policy>
+void Processor<Policy>::loadStage(CheckpointReader& in, PipelineStage& stage) {
+    uint32_t index = in.u32();
+    if (index != 0xFFFFFFFF && index >= program.size()) {
+        throw std::runtime_error("Checkpoint latch refers to a missing instruction");
+    }
+    stage.instruction = index == 0xFFFFFFFF ? nullptr : &program.instructions[index];
+    stage.programCounter = in.u32();
+    stage.hasData = in.u8() != 0;
+    stage.aluResult = static_cast<int32_t>(in.u32());
+    stage.memoryData = static_cast<int32_t>(in.u32());
+    stage.predictedTaken = in.u8() != 0;
+    stage.predictedTarget = in.u32();
+    stage.resolvedTaken = in.u8() != 0;
+    stage.resolvedTarget = in.u32();
+    if (stage.hasData && !stage.instruction) {
+        throw std::runtime_error("Checkpoint latch holds an instruction without a record");
     }
+}
 
-    if (canFetch) {
-        auto [code, text] = programMemory[currentAddress];
-        fetchToDecode.instruction = InstructionDetails(false);
-        fetchToDecode.instruction.machineCode = code;
-        fetchToDecode.instruction.assemblyText = text;
-        fetchToDecode.instruction.programCounter = currentAddress;
-        fetchToDecode.hasData = true;
-        logStage(currentAddress, "IF");
-        programCounter += 4;
-    } else {
-        fetchToDecode.instruction = InstructionDetails(true);
-        fetchToDecode.hasData = false;
+template <typename Policy>
+void Processor<Policy>::saveCheckpoint(const std::string& path) const {
+    CheckpointWriter out;
+    out.header(Policy::name, program);
+    out.archState(state);
+
+    for (int field : {depth.fetchStages, depth.executeStages, depth.memoryStages, depth.aluLatency,
+                      depth.loadLatency, depth.storeLatency, depth.branchLatency}) {
+        out.u32(static_cast<uint32_t>(field));
+    }
+    out.u64(static_cast<uint64_t>(currentCycleCount));
+    for (const PipelineStage& stage : fetchLatches) saveStage(out, stage);
+    saveStage(out, fetchToDecode);
+    saveStage(out, decodeToExecute);
+    for (const PipelineStage& stage : executeToWriteback) saveStage(out, stage);
+    out.u8(wrongPath);
+    out.u64(static_cast<uint64_t>(static_cast<int64_t>(redirectCycle)));
+    out.u32(redirectTarget);
+    out.u32(redirectSource);
+    out.u8(static_cast<uint8_t>(redirectCause));
+    out.u32(lastPassedAddress);
+    for (const LoggedStage& last : lastLogged) {
+        out.u32(last.address);
+        out.u64(static_cast<uint64_t>(static_cast<int64_t>(last.cycle)));
     }
+    predictor.save(out);
+    icache.save(out);
+    dcache.save(out);
+    out.u8(fetchPending);
+    out.u32(fetchPendingAddress);
+    out.u32(fetchWaitCycles);
+    out.u8(memoryPending);
+    out.u32(memoryWaitCycles);
+    muldiv.save(out);
+    for (int ready : resultReady) out.u64(static_cast<uint64_t>(static_cast<int64_t>(ready)));
+    out.writeTo(path);
 }
 
-void Processor::decodeInstruction() {
-    if (currentCycleCount >= maxCycleLimit) return;
-    uint32_t instructionAddress = fetchToDecode.hasData ? fetchToDecode.instruction.programCounter : 0;
-    bool hasValidInstruction = fetchToDecode.hasData && !fetchToDecode.instruction.isEmpty;
+template <typename Policy>
+void Processor<Policy>::loadCheckpoint(const std::string& path) {
+    CheckpointReader in(path);
+    in.header(Policy::name, program);
+    in.archState(state);
 
-    if (clearFetchDecode) {
-        if (hasValidInstruction) logStage(instructionAddress, "-");
-        fetchToDecode.instruction = InstructionDetails(true);
-        fetchToDecode.hasData = false;
-        clearFetchDecode = false;
-        hasValidInstruction = false;
+    for (int field : {depth.fetchStages, depth.executeStages, depth.memoryStages, depth.aluLatency,
+                      depth.loadLatency, depth.storeLatency, depth.branchLatency}) {
+        if (in.u32() != static_cast<uint32_t>(field)) {
+            throw std::runtime_error("Checkpoint was taken with a different pipeline depth");
+        }
     }
+    currentCycleCount = static_cast<int>(in.u64());
+    for (PipelineStage& stage : fetchLatches) loadStage(in, stage);
+    loadStage(in, fetchToDecode);
+    loadStage(in, decodeToExecute);
+    for (PipelineStage& stage : executeToWriteback) loadStage(in, stage);
+    wrongPath = in.u8() != 0;
+    redirectCycle = static_cast<int>(static_cast<int64_t>(in.u64()));
+    redirectTarget = in.u32();
+    redirectSource = in.u32();
+    redirectCause = static_cast<CycleCause>(in.u8());
+    lastPassedAddress = in.u32();
+    for (LoggedStage& last : lastLogged) {
+        last.address = in.u32();
+        last.cycle = static_cast<int>(static_cast<int64_t>(in.u64()));
+    }
+    predictor.load(in);
+    icache.load(in);
+    dcache.load(in);
+    fetchPending = in.u8() != 0;
+    fetchPendingAddress = in.u32();
+    fetchWaitCycles = in.u32();
+    memoryPending = in.u8() != 0;
+    memoryWaitCycles = in.u32();
+    muldiv.load(in);
+    for (int& ready : resultReady) ready = static_cast<int>(static_cast<int64_t>(in.u64()));
+    in.finish();
+
+    // Sequence numbers only name instances in traces; the restored ones
+    // are numbered afresh, oldest first
+    fetchSequence = 0;
+    auto renumber = [this](PipelineStage& stage) { stage.sequence = stage.hasData ? nextSequence++ : 0; };
+    std::for_each(executeToWriteback.rbegin(), executeToWriteback.rend(), renumber);
+    renumber(decodeToExecute);
+    renumber(fetchToDecode);
+    std::for_each(fetchLatches.rbegin(), fetchLatches.rend(), renumber);
+}
 
-    if (!hasValidInstruction) {
-        decodeToExecute.instruction = InstructionDetails(true);
-        decodeToExecute.hasData = false;
+// `held` marks an instruction that could not leave `stage` this cycle.
+template <typename Policy>
+void Processor<Policy>::logStage(uint32_t address, uint64_t sequence, Stage stage, bool held, int index) {
+    if (cycleStream.isOpen()) {
+        cycleStream.occupy(stage, address, 0, index);
+        if (held) cycleStream.markStall();
         return;
     }
-
-    InstructionDetails current = fetchToDecode.instruction;
-    if (hasDataHazard(current)) {
-        pausePipeline = true;
-        decodeToExecute.instruction = InstructionDetails(true);
-        decodeToExecute.hasData = false;
-        logStage(current.programCounter, "-");
+    if (!keepHistory && !trace.isOpen()) return;
+
+    Stage drawn = held ? Stage::Stall : stage;
+    if constexpr (Policy::repeatAsStall) {
+        if (stage != Stage::WB) {
+            drawn = stage;
+            LoggedStage& last = lastLogged[depth.column(stage, index)];
+            if (last.address == address && last.cycle == currentCycleCount - 1) drawn = Stage::Stall;
+            last.address = address;
+            last.cycle = currentCycleCount;
+        }
+    }
+    if (trace.isOpen()) {
+        trace.stage(currentCycleCount - firstCycle, sequence, program.index(address), stage, drawn == Stage::Stall, 0,
+                    depth.label(stage, index));
         return;
     }
+    pipelineHistory.record(program.index(address), currentCycleCount - firstCycle, drawn, 0, depth.label(stage, index));
+}
+
+// The sequence number of the instruction IF is fetching from `address`:
+// the same as last cycle while IF keeps at it, else a new one. One that IF
+// gave up on (after a redirect) is flushed from the trace.
+template <typename Policy>
+uint64_t Processor<Policy>::fetchInstance(uint32_t address) {
+    if (fetchSequence && fetchSequenceAddress == address) return fetchSequence;
+    if (fetchSequence && trace.isOpen()) trace.flush(currentCycleCount - firstCycle, fetchSequence);
+    fetchSequence = nextSequence++;
+    fetchSequenceAddress = address;
+    return fetchSequence;
+}
 
-    decodeToExecute.instruction = interpretInstruction(current.machineCode, current.programCounter);
-    decodeToExecute.instruction.assemblyText = current.assemblyText;
-    decodeToExecute.hasData = !decodeToExecute.instruction.isEmpty;
-    if (decodeToExecute.hasData) {
-        logStage(decodeToExecute.instruction.programCounter, "ID");
+// Drops the instruction in `stage`, fetched down a path fetch has left.
+template <typename Policy>
+void Processor<Policy>::squash(PipelineStage& stage) {
+    if (stage.hasData) {
+        cycleStream.markFlush();
+        counters.flush(program.index(stage.programCounter));
+        if (trace.isOpen()) trace.flush(currentCycleCount - firstCycle, stage.sequence);
     }
+    stage = PipelineStage();
 }
 
-bool Processor::hasDataHazard(const InstructionDetails& current) {
-    uint32_t code = current.machineCode;
-    uint32_t reg1 = (code >> 15) & 0x1F; // rs1
-    uint32_t reg2 = (code >> 20) & 0x1F; // rs2
-    bool usesReg1 = reg1 != 0;
-    bool usesReg2 = reg2 != 0;
+template <typename Policy>
+bool Processor<Policy>::isProgramAddress(uint32_t address) const {
+    return program.contains(address);
+}
 
-    if (executeToMemory.hasData && !executeToMemory.instruction.isEmpty && 
-        executeToMemory.instruction.writesRegister) {
-        uint32_t targetReg = executeToMemory.instruction.destReg;
-        if (targetReg != 0 && ((usesReg1 && targetReg == reg1) || (usesReg2 && targetReg == reg2))) {
-            return true;
-        }
+template <typename Policy>
+void Processor<Policy>::redirect(uint32_t target, int delay) {
+    redirectTarget = target;
+    redirectCycle = currentCycleCount + delay;
+}
+
+static bool predictedCorrectly(const PipelineStage& stage, bool taken, uint32_t target) {
+    return stage.predictedTaken == taken && (!taken || stage.predictedTarget == target);
+}
+
+// Checks a resolved branch or jump against what IF predicted for it and
+// redirects fetch when it went the wrong way; true if it did.
+template <typename Policy>
+bool Processor<Policy>::resolveControl(const PipelineStage& stage, bool taken, uint32_t target, int delay) {
+    bool conditional = stage.instruction->branchKind == BRANCH_CONDITIONAL;
+    bool correct = predictedCorrectly(stage, taken, target);
+    counters.resolve(conditional, correct);
+    // Targets outside the program (STOP_ADDRESS) are never predicted
+    if (predictor.enabled() && (!taken || isProgramAddress(target))) {
+        predictor.update(stage.programCounter, conditional, taken, target);
+    }
+    if (!correct) {
+        redirect(taken ? target : stage.programCounter + 4, delay);
+        redirectSource = stage.programCounter;
+        // Fetch either went straight on past a taken branch or followed a
+        // wrong prediction
+        redirectCause = stage.predictedTaken ? CycleCause::Flush : CycleCause::TakenBranch;
+    }
+    return !correct;
+}
+
+// Charges a cycle in which ID has nothing to pass on: to the branch or
+// jump whose redirect emptied it (for as many cycles as fetch takes to
+// refill), to the instruction IF is fetching, or, once fetch has stopped,
+// to the last instruction ID passed on.
+template <typename Policy>
+void Processor<Policy>::profileEmptyDecode() {
+    if (!profile.enabled()) return;
+    if (redirectCycle <= currentCycleCount && currentCycleCount < redirectCycle + depth.fetchStages) {
+        profile.charge(program.index(redirectSource), redirectCause);
+    } else if (state.halt == ProgramHalt::None && isProgramAddress(state.pc)) {
+        profile.charge(program.index(state.pc), CycleCause::Fetch);
+    } else {
+        profile.charge(program.index(lastPassedAddress), CycleCause::Drain);
     }
+}
 
-    if (memoryToWriteback.hasData && !memoryToWriteback.instruction.isEmpty && 
-        memoryToWriteback.instruction.writesRegister) {
-        uint32_t targetReg = memoryToWriteback.instruction.destReg;
-        if (targetReg != 0 && ((usesReg1 && targetReg == reg1) || (usesReg2 && targetReg == reg2))) {
-            return true;
+template <typename Policy>
+uint32_t Processor<Policy>::jumpTarget(const DecodedInstruction& current, uint32_t address,
+                                       int32_t base) const {
+    if (current.branchKind != BRANCH_JALR) {
+        return address + current.immediate;
+    }
+    if constexpr (Policy::haltOnReturn) {
+        if (static_cast<uint32_t>(base) == STOP_ADDRESS) {
+            return STOP_ADDRESS; // returning from the top-level function
         }
     }
-    return false;
+    return (static_cast<uint32_t>(base) + current.immediate) & ~1U;
 }
 
-InstructionDetails Processor::interpretInstruction(uint32_t machineCode, uint32_t address) {
-    InstructionDetails details(false);
-    details.machineCode = machineCode;
-    details.programCounter = address;
+// Advances the I-cache access for `address` by one cycle, starting it if
+// IF was working on something else; true once the instruction is there.
+template <typename Policy>
+bool Processor<Policy>::fetchReady(uint32_t address) {
+    if (!icache.enabled()) return true;
+    if (!fetchPending || fetchPendingAddress != address) {
+        fetchPending = true;
+        fetchPendingAddress = address;
+        fetchWaitCycles = icache.access(address, false, counters.icache);
+    }
+    if (fetchWaitCycles > 0) --fetchWaitCycles;
+    return fetchWaitCycles == 0;
+}
 
-    // Extract instruction fields
-    details.opcode = machineCode & 0x7F;
-    details.destReg = (machineCode >> 7) & 0x1F;
-    details.func3 = (machineCode >> 12) & 0x7;
-    details.srcReg1 = (machineCode >> 15) & 0x1F;
-    details.srcReg2 = (machineCode >> 20) & 0x1F;
-    details.func7 = (machineCode >> 25) & 0x7F;
+// The same for the load or store in EX/MEM and the D-cache.
+template <typename Policy>
+bool Processor<Policy>::memoryReady(uint32_t address, bool write) {
+    if (!memoryPending) {
+        memoryPending = true;
+        memoryWaitCycles = sharedMemory ? sharedMemory->access(coreId, address, write, dcache, counters.dcache)
+                                        : dcache.access(address, write, counters.dcache);
+    }
+    if (memoryWaitCycles > 0) --memoryWaitCycles;
+    return memoryWaitCycles == 0;
+}
 
-    switch (details.opcode) {
-        case 0x33: // R-type 
-            details.writesRegister = (details.destReg != 0);
-            break;
+// Number of cycles from now in which the pipeline is frozen behind a cache
+// access that is already in progress or behind the multiply/divide unit,
+// so that every stage would only log a hold and count down a wait. Zero
+// when something can move this cycle.
+//   - D-cache: the load or store entering MEM1 still waits, the MEM
+//     sub-stages after it have drained and ID holds an instruction, so
+//     IF is paused too.
+//   - multiply/divide: ID waits on the unit with nothing ahead of it.
+//   - I-cache: every latch is empty and IF waits on the miss.
+// In the first two, every fetch sub-stage must be full for IF1 to hold.
+// A redirect due now or an I-cache access that would start this cycle
+// rules the window out.
+template <typename Policy>
+int Processor<Policy>::idleCycles() const {
+    if (redirectCycle == currentCycleCount) return 0;
+    bool fetchWaits = fetchPending && fetchPendingAddress == state.pc;
+    bool fetchIdle = (!icache.enabled() || !isProgramAddress(state.pc) || fetchWaits) &&
+                     std::all_of(fetchLatches.begin(), fetchLatches.end(),
+                                 [](const PipelineStage& stage) { return stage.hasData; });
+    bool memoryDrained = std::none_of(executeToWriteback.begin() + depth.executeStages, executeToWriteback.end(),
+                                      [](const PipelineStage& stage) { return stage.hasData; });
+
+    if (memoryPending && memoryWaitCycles >= 2 && executeToWriteback[depth.executeStages - 1].hasData &&
+        memoryDrained && fetchToDecode.hasData) {
+        return fetchIdle ? static_cast<int>(memoryWaitCycles - 1) : 0;
+    }
+    bool executeEmpty = !decodeToExecute.hasData && !inFlight(executeToWriteback);
+    if (fetchToDecode.hasData && executeEmpty && fetchIdle) {
+        int cycles = 0;
+        mulDivHazard(*fetchToDecode.instruction, cycles);
+        return cycles;
+    }
+    if (fetchWaits && fetchWaitCycles >= 2 && isProgramAddress(state.pc) && !inFlight(fetchLatches) &&
+        !fetchToDecode.hasData && executeEmpty) {
+        return static_cast<int>(fetchWaitCycles - 1);
+    }
+    return 0;
+}
 
-        case 0x13: // I-type ALU 
-            if (machineCode == 0x00000013) return InstructionDetails(true); // NOP
-            details.writesRegister = (details.destReg != 0);
-            details.immediate = (int32_t)(machineCode & 0xFFF00000) >> 20;
-            break;
+// Applies `cycles` idle cycles found by idleCycles() as the stage functions
+// would have: counters and wait counts in one step, and the held stages
+// once per cycle when a diagram, stream or trace is being written.
+template <typename Policy>
+void Processor<Policy>::skipIdleCycles(int cycles) {
+    const PipelineStage& memoryInput = executeToWriteback[depth.executeStages - 1];
+    bool memoryWaits = memoryPending && memoryInput.hasData;
+    bool fetchWaits = isProgramAddress(state.pc);
+    uint32_t elapsed = static_cast<uint32_t>(cycles);
+
+    if (cycleStream.isOpen() || keepHistory || trace.isOpen()) {
+        for (int cycle = 0; cycle < cycles; ++cycle, ++currentCycleCount) {
+            if (cycleStream.isOpen()) cycleStream.beginCycle(currentCycleCount + 1);
+            if (memoryWaits) {
+                logStage(memoryInput.programCounter, memoryInput.sequence, Stage::MEM, true);
+                for (int index = depth.executeStages - 1; index >= 0; --index) {
+                    const PipelineStage& stage = index ? executeToWriteback[index - 1] : decodeToExecute;
+                    if (stage.hasData) logStage(stage.programCounter, stage.sequence, Stage::EX, true, index);
+                }
+            }
+            if (fetchToDecode.hasData) logStage(fetchToDecode.programCounter, fetchToDecode.sequence, Stage::ID, true);
+            for (int index = static_cast<int>(fetchLatches.size()) - 1; index >= 0; --index) {
+                const PipelineStage& stage = fetchLatches[index];
+                if (stage.hasData) logStage(stage.programCounter, stage.sequence, Stage::IF, true, index + 1);
+            }
+            if (fetchWaits) logStage(state.pc, fetchInstance(state.pc), Stage::IF, true);
+            if (cycleStream.isOpen()) cycleStream.endCycle();
+        }
+        currentCycleCount -= cycles;
+    }
 
-        case 0x03: // I-type Load 
-            details.writesRegister = (details.destReg != 0);
-            details.readsMemory = true;
-            details.immediate = (int32_t)(machineCode & 0xFFF00000) >> 20;
-            break;
+    if (memoryWaits) {
+        memoryWaitCycles -= elapsed;
+        counters.stall(StallCause::DataCache, program.index(fetchToDecode.programCounter), elapsed);
+        profile.charge(program.index(fetchToDecode.programCounter), StallCause::DataCache, elapsed);
+        executeToWriteback[depth.executeStages] = PipelineStage();
+    } else if (fetchToDecode.hasData) {
+        int unused = 0;
+        StallCause cause = mulDivHazard(*fetchToDecode.instruction, unused);
+        counters.stall(cause, program.index(fetchToDecode.programCounter), elapsed);
+        profile.charge(program.index(fetchToDecode.programCounter), cause, elapsed);
+        decodeToExecute = PipelineStage();
+        std::fill(executeToWriteback.begin(), executeToWriteback.end(), PipelineStage());
+    } else {
+        // Cycles still refilling fetch after a redirect are the branch's, as in profileEmptyDecode()
+        int refill = std::clamp(redirectCycle + depth.fetchStages - currentCycleCount, 0, cycles);
+        profile.charge(program.index(redirectSource), redirectCause, static_cast<uint32_t>(refill));
+        profile.charge(program.index(state.pc), CycleCause::Fetch, elapsed - static_cast<uint32_t>(refill));
+        fetchToDecode = PipelineStage();
+        decodeToExecute = PipelineStage();
+        std::fill(executeToWriteback.begin(), executeToWriteback.end(), PipelineStage());
+    }
+    if (fetchWaits && fetchPending && fetchPendingAddress == state.pc) {
+        fetchWaitCycles -= std::min(fetchWaitCycles, elapsed);
+    }
+    pausePipeline = fetchToDecode.hasData;
+    memoryStalled = memoryWaits;
+}
 
-        case 0x23: // S-type Store 
-            details.writesMemory = true;
-            details.immediate = ((int32_t)(machineCode & 0xFE000000) >> 20) | 
-                               ((machineCode >> 7) & 0x1F);
-            if (details.immediate & 0x800) details.immediate |= 0xFFFFF000;
-            break;
+template <typename Policy>
+void Processor<Policy>::fetchInstruction() {
+    // Nothing is fetched behind an exit or EBREAK
+    if (state.halt != ProgramHalt::None) {
+        fetchToDecode = PipelineStage();
+        std::fill(fetchLatches.begin(), fetchLatches.end(), PipelineStage());
+        return;
+    }
+    // The later fetch sub-stages first: each moves on once the latch ahead
+    // is free, and the last one unless ID held its instruction.
+    // fetchLatches[k] is in IF(k+2) this cycle.
+    for (int index = static_cast<int>(fetchLatches.size()) - 1; index >= 0; --index) {
+        PipelineStage& stage = fetchLatches[index];
+        bool last = index + 1 == static_cast<int>(fetchLatches.size());
+        bool held = last ? pausePipeline : fetchLatches[index + 1].hasData;
+        if (stage.hasData) logStage(stage.programCounter, stage.sequence, Stage::IF, held, index + 1);
+        if (held) continue;
+        (last ? fetchToDecode : fetchLatches[index + 1]) = stage;
+        stage = PipelineStage();
+    }
 
-        case 0x63: // B-type Branch
-            details.immediate = (((int32_t)(machineCode & 0x80000000) >> 19)) | 
-                               ((machineCode & 0x80) << 4) | 
-                               ((machineCode >> 20) & 0x7E0) | 
-                               ((machineCode >> 7) & 0x1E);
-            if (details.immediate & 0x1000) details.immediate |= 0xFFFFE000;
-            break;
+    uint32_t currentAddress = state.pc;
+    bool canFetch = isProgramAddress(currentAddress);
+    PipelineStage& fetched = fetchLatches.empty() ? fetchToDecode : fetchLatches[0];
 
-        case 0x6F: // J-type JAL
-            details.writesRegister = (details.destReg != 0);
-            details.isJump = true;
-            details.immediate = (((int32_t)(machineCode & 0x80000000) >> 11)) | 
-                               (machineCode & 0xFF000) | 
-                               ((machineCode >> 9) & 0x800) | 
-                               ((machineCode >> 20) & 0x7FE);
-            if (details.immediate & 0x100000) details.immediate |= 0xFFE00000;
-            break;
+    if (fetchLatches.empty() ? pausePipeline : fetched.hasData) {
+        if (canFetch) {
+            fetchReady(currentAddress); // the access carries on behind the stall
+            logStage(currentAddress, fetchInstance(currentAddress), Stage::IF, true);
+        }
+        return;
+    }
 
-        case 0x67: // I-type JALR
-            if (details.func3 == 0x0) {
-                details.writesRegister = (details.destReg != 0);
-                details.isJump = true;
-                details.immediate = (int32_t)(machineCode & 0xFFF00000) >> 20;
-            } else {
-                std::cerr << "Warning: Unknown JALR funct3 at 0x" << std::hex << address << std::dec << std::endl;
-                return InstructionDetails(true);
+    if (redirectCycle == currentCycleCount) {
+        currentAddress = state.pc = redirectTarget;
+        canFetch = isProgramAddress(currentAddress);
+    }
+
+    if (canFetch && !fetchReady(currentAddress)) {
+        fetched = PipelineStage();
+        logStage(currentAddress, fetchInstance(currentAddress), Stage::IF, true);
+        return;
+    }
+
+    if (canFetch) {
+        fetchPending = false;
+        fetched.instruction = &program.instructions[program.index(currentAddress)];
+        fetched.programCounter = currentAddress;
+        fetched.hasData = true;
+        fetched.predictedTaken = false;
+        fetched.sequence = fetchInstance(currentAddress);
+        fetchSequence = 0;
+        logStage(currentAddress, fetched.sequence, Stage::IF);
+        state.pc += 4;
+        if (predictor.enabled()) {
+            bool btbHit = false;
+            Prediction prediction = predictor.predict(currentAddress, btbHit);
+            ++counters.btbLookups;
+            if (btbHit) ++counters.btbHits;
+            if (prediction.taken) {
+                fetched.predictedTaken = true;
+                fetched.predictedTarget = prediction.target;
+                state.pc = prediction.target;
             }
-            break;
+        }
+    } else {
+        fetched = PipelineStage();
+    }
+}
 
-        case 0x37: // U-type LUI
-            details.writesRegister = (details.destReg != 0);
-            details.immediate = (int32_t)(machineCode & 0xFFFFF000);
-            break;
+template <typename Policy>
+void Processor<Policy>::decodeInstruction() {
+    // The instructions fetched behind a taken branch or jump are dropped
+    if (redirectCycle == currentCycleCount) {
+        squash(fetchToDecode);
+        for (PipelineStage& stage : fetchLatches) squash(stage);
+    }
 
-        case 0x17: // U-type AUIPC
-            details.writesRegister = (details.destReg != 0);
-            details.immediate = (int32_t)(machineCode & 0xFFFFF000);
-            break;
+    // A D-cache wait freezes ID/EX, so the instruction stays in ID
+    if (memoryStalled) {
+        if (fetchToDecode.hasData) {
+            counters.stall(StallCause::DataCache, program.index(fetchToDecode.programCounter));
+            profile.charge(program.index(fetchToDecode.programCounter), StallCause::DataCache);
+            pausePipeline = true;
+            logStage(fetchToDecode.programCounter, fetchToDecode.sequence, Stage::ID, true);
+        } else {
+            profileEmptyDecode();
+        }
+        return;
+    }
+
+    if (!fetchToDecode.hasData) {
+        profileEmptyDecode();
+        decodeToExecute = PipelineStage();
+        return;
+    }
 
-        case 0x73: // System (ECALL/EBREAK)
-        case 0x0F: // Fence
-        case 0x00: // Zero instruction
-            return InstructionDetails(true);
+    const DecodedInstruction& current = *fetchToDecode.instruction;
+    StallCause cause = StallCause::None;
+    int waitCycles = 0;
+    updateScoreboard(0);
+    if (current.system != SYSTEM_NONE) {
+        // ECALL and EBREAK wait until every older instruction has written back
+        if (inFlight(executeToWriteback)) cause = StallCause::Serialize;
+    } else {
+        cause = dataHazard(current);
+        if (cause == StallCause::None) cause = mulDivHazard(current, waitCycles);
+    }
+    if (cause != StallCause::None) {
+        counters.stall(cause, program.index(fetchToDecode.programCounter));
+        profile.charge(program.index(fetchToDecode.programCounter), cause);
+        pausePipeline = true;
+        decodeToExecute = PipelineStage();
+        logStage(fetchToDecode.programCounter, fetchToDecode.sequence, Stage::ID, true);
+        return;
+    }
 
-        default:
-            std::cerr << "Warning: Unknown opcode 0x" << std::hex << details.opcode 
-                      << " at 0x" << address << std::dec << std::endl;
-            return InstructionDetails(true);
+    profile.charge(program.index(fetchToDecode.programCounter), CycleCause::Useful);
+    lastPassedAddress = fetchToDecode.programCounter;
+    // The record was prepared at load time; bubbles (nop, fence, system) may stop here.
+    if constexpr (Policy::squashNops) {
+        if (current.has(DEC_BUBBLE)) {
+            if (trace.isOpen()) trace.flush(currentCycleCount - firstCycle, fetchToDecode.sequence);
+            decodeToExecute = PipelineStage();
+            return;
+        }
+    }
+    decodeToExecute = fetchToDecode;
+    if (current.system != SYSTEM_NONE) {
+        executeSystem(decodeToExecute);
+    } else if constexpr (Policy::resolveInDecode) {
+        resolveInDecode(decodeToExecute);
     }
-    return details;
+    logStage(decodeToExecute.programCounter, decodeToExecute.sequence, Stage::ID);
 }
 
-void Processor::executeInstruction() {
-    if (currentCycleCount >= maxCycleLimit) return;
-    if (!decodeToExecute.hasData || decodeToExecute.instruction.isEmpty) {
-        executeToMemory.instruction = InstructionDetails(true);
-        executeToMemory.hasData = false;
+// Runs an ECALL or EBREAK in ID, where the pipeline ahead of it is empty:
+// registers and memory are up to date, and instructions behind it read the
+// result when they reach ID. It then passes down the pipeline as a nop.
+template <typename Policy>
+void Processor<Policy>::executeSystem(const PipelineStage& stage) {
+    haltAddress = stage.programCounter;
+    if (stage.instruction->system == SYSTEM_EBREAK) {
+        state.halt = ProgramHalt::Breakpoint;
         return;
     }
+    uint64_t cycle = static_cast<uint64_t>(currentCycleCount);
+    if (sharedMemory) {
+        sharedMemory->exclusive([&](DataMemory& memory, uint32_t& programBreak) {
+            state.programBreak = programBreak;
+            systemCalls.call(state, state.registers, memory, cycle);
+            programBreak = state.programBreak;
+        });
+    } else {
+        systemCalls.call(state, state.registers, state.memory, cycle);
+    }
+}
 
-    executeToMemory = decodeToExecute;
-    InstructionDetails& current = executeToMemory.instruction;
+// Points the scoreboard at the writes in the latches from
+// executeToWriteback[from] on. A stage that runs after the one before it
+// has moved on leaves that one's latch out: it only holds a copy.
+template <typename Policy>
+void Processor<Policy>::updateScoreboard(int from) {
+    scoreboard.clear();
+    for (int position = static_cast<int>(executeToWriteback.size()) - 1; position >= from; --position) {
+        scoreboard.add(position, executeToWriteback[position]);
+    }
+}
 
-    if (current.isJump) {
-        clearFetchDecode = true;
-        if (current.opcode == 0x6F) { // JAL
-            programCounter = current.programCounter + current.immediate;
-        } else if (current.opcode == 0x67) { // JALR
-            if (current.srcReg1 == 1 && current.immediate == 0 && current.destReg == 0) {
-                programCounter = STOP_ADDRESS;
-            } else {
-                programCounter = (0 + current.immediate) & ~1U;
+// With forwarding, a result can be bypassed once its producer has left the
+// sub-stage that computes it: the `alu` EX sub-stage, or the `load` MEM
+// sub-stage for loads. Seen from ID, that takes the producer's latch up
+// to that sub-stage's, and the consumer has until it reads the operand:
+// the next cycle in EX1, now for branches and jalr read in ID, and the
+// `store` MEM sub-stage for store data. A store address may take a load's
+// data in the cycle MEM produces it, as the five-stage pipeline always has.
+template <typename Policy>
+StallCause Processor<Policy>::dataHazard(const DecodedInstruction& current) const {
+    if constexpr (Policy::forwarding) {
+        bool readInDecode = current.branchKind == BRANCH_CONDITIONAL || current.branchKind == BRANCH_JALR;
+        bool store = current.has(DEC_MEM_WRITE);
+        // Matched against the raw register fields, as the hardware comparators would be
+        uint32_t sources = scoreboard.pendingIn((1u << current.srcReg1) | (1u << current.srcReg2));
+        for (; sources; sources &= sources - 1) {
+            int reg = __builtin_ctz(sources);
+            bool load = scoreboard.loadsIn(1u << reg) != 0;
+            int produced = load ? depth.executeStages + depth.loadStage() - 1 : depth.aluLatency - 1;
+            int needed = readInDecode                 ? -1
+                         : !store                    ? 0
+                         : reg != current.srcReg1    ? depth.executeStages + depth.storeLatency - 1
+                         : load                      ? 1
+                                                     : 0;
+            if (produced - scoreboard.position(reg) > needed) {
+                if (readInDecode) return StallCause::BranchOperand;
+                return load ? StallCause::LoadUse : StallCause::ExecuteLatency;
             }
         }
+        return StallCause::None;
+    } else {
+        return scoreboard.pendingIn(current.srcMask) ? StallCause::Writeback : StallCause::None;
+    }
+}
+
+// RV32M results become usable `latency` cycles after entering EX. With
+// forwarding an instruction may leave ID one cycle before that; operands
+// read in ID, or through the register file, are needed one cycle after.
+// `cycles` is set to how long the stall will last.
+template <typename Policy>
+StallCause Processor<Policy>::mulDivHazard(const DecodedInstruction& current, int& cycles) const {
+    bool readInDecode = Policy::resolveInDecode && (current.branchKind == BRANCH_CONDITIONAL ||
+                                                    current.branchKind == BRANCH_JALR);
+    int slack = Policy::forwarding && !readInDecode ? -1 : 1;
+    int wait = 0;
+    for (uint32_t sources = current.srcMask; sources; sources &= sources - 1) {
+        wait = std::max(wait, resultReady[__builtin_ctz(sources)] + slack - currentCycleCount);
+    }
+    if (wait > 0) {
+        cycles = wait;
+        return StallCause::MulDivResult;
+    }
+    if (current.has(DEC_MULDIV)) {
+        wait = muldiv.acceptCycle(current.aluOp) - (currentCycleCount + 1);
+        if (wait > 0) {
+            cycles = wait;
+            return StallCause::MulDivBusy;
+        }
     }
-    logStage(current.programCounter, "EX");
+    return StallCause::None;
 }
 
-void Processor::accessMemory() {
-    if (currentCycleCount >= maxCycleLimit) return;
-    if (!executeToMemory.hasData || executeToMemory.instruction.isEmpty) {
-        memoryToWriteback.instruction = InstructionDetails(true);
-        memoryToWriteback.hasData = false;
+template <typename Policy>
+void Processor<Policy>::resolveInDecode(const PipelineStage& stage) {
+    const DecodedInstruction& current = *stage.instruction;
+    uint32_t address = stage.programCounter;
+    if (current.isJump()) {
+        int32_t base = current.branchKind == BRANCH_JALR ? decodeOperand(current.srcReg1) : 0;
+        resolveControl(stage, true, jumpTarget(current, address, base), 1);
         return;
     }
+    if (current.branchKind != BRANCH_CONDITIONAL) return;
+
+    int32_t operand1 = decodeOperand(current.srcReg1);
+    int32_t operand2 = decodeOperand(current.srcReg2);
+    bool taken = branchTaken(current.branchOp, operand1, operand2);
+    resolveControl(stage, taken, address + current.immediate, 1);
+}
 
-    memoryToWriteback = executeToMemory;
-    logStage(memoryToWriteback.instruction.programCounter, "MEM");
+// Whether pending register `reg` is bypassed from MEM/WB rather than
+// EX/MEM: named, like the hardware path, by the latch its producer held at
+// the start of this cycle, one before the one it has just moved to. Any
+// latch up to EX/MEM counts as EX/MEM and any after it as MEM/WB; loaded
+// data only ever comes from MEM/WB.
+template <typename Policy>
+bool Processor<Policy>::bypassedFromMemory(int reg) const {
+    return scoreboard.loadsIn(1u << reg) || scoreboard.position(reg) - 1 >= depth.executeStages;
+}
+
+// `reg` as read in ID: bypassed from the youngest instruction after EX1
+// that writes it (dataHazard() holds ID until its result is there), else
+// from the register file.
+template <typename Policy>
+int32_t Processor<Policy>::decodeOperand(uint8_t reg) {
+    if constexpr (Policy::forwarding) {
+        if (scoreboard.pendingIn(1u << reg)) {
+            counters.forward(bypassedFromMemory(reg) ? ForwardPath::MemWbToId : ForwardPath::ExMemToId);
+            return scoreboard.value(reg);
+        }
+    }
+    return state.registers[reg];
 }
 
-void Processor::writeBackToRegisters() {
-    if (currentCycleCount >= maxCycleLimit) return;
-    if (!memoryToWriteback.hasData || memoryToWriteback.instruction.isEmpty) return;
-    logStage(memoryToWriteback.instruction.programCounter, "WB");
+template <typename Policy>
+void Processor<Policy>::executeInstruction() {
+    // A D-cache wait freezes every EX sub-stage
+    if (memoryStalled) {
+        for (int index = depth.executeStages - 1; index >= 0; --index) {
+            const PipelineStage& stage = index ? executeToWriteback[index - 1] : decodeToExecute;
+            if (stage.hasData) logStage(stage.programCounter, stage.sequence, Stage::EX, true, index);
+        }
+        return;
+    }
+
+    // The later sub-stages first; executeToWriteback[index] leaves EX(index + 1)
+    for (int index = depth.executeStages - 1; index > 0; --index) {
+        PipelineStage& stage = executeToWriteback[index];
+        stage = executeToWriteback[index - 1];
+        if (!stage.hasData) continue;
+        logStage(stage.programCounter, stage.sequence, Stage::EX, false, index);
+        if constexpr (!Policy::resolveInDecode) {
+            if (index + 1 == depth.branchLatency && stage.instruction->branchKind != BRANCH_NONE &&
+                resolveControl(stage, stage.resolvedTaken, stage.resolvedTarget, 0)) {
+                // Drop what followed it into EX; executeToWriteback[index - 1]
+                // is its own copy
+                for (int younger = index - 2; younger >= 0; --younger) squash(executeToWriteback[younger]);
+                squash(decodeToExecute);
+                std::fill(executeToWriteback.begin(), executeToWriteback.begin() + index, PipelineStage());
+                wrongPath = false;
+                return;
+            }
+        }
+    }
+
+    PipelineStage& executed = executeToWriteback[0];
+    if (!decodeToExecute.hasData) {
+        executed = PipelineStage();
+        return;
+    }
+    if (wrongPath) {
+        // Behind a branch or jump that will redirect fetch: carried along
+        // until it is dropped, without touching anything on the way
+        executed = decodeToExecute;
+        logStage(executed.programCounter, executed.sequence, Stage::EX);
+        return;
+    }
+
+    const DecodedInstruction& current = *decodeToExecute.instruction;
+    uint8_t rs1 = current.has(DEC_USES_RS1) ? current.srcReg1 : 0;
+    uint8_t rs2 = current.has(DEC_USES_RS2) ? current.srcReg2 : 0;
+    int32_t operand1 = state.registers[rs1];
+    int32_t operand2 = current.has(DEC_ALU_IMM) ? current.immediate : state.registers[rs2];
+
+    if constexpr (Policy::forwarding) {
+        // The previous instruction has just moved on to EX2 or MEM1; older
+        // results are further on or already in the register file. Each
+        // operand is bypassed on its own, and store data waits for MEM.
+        updateScoreboard(1);
+        auto bypass = [this](uint8_t reg, int32_t& operand) {
+            if (!scoreboard.pendingIn(1u << reg)) return;
+            operand = scoreboard.value(reg);
+            counters.forward(bypassedFromMemory(reg) ? ForwardPath::MemWbToEx : ForwardPath::ExMemToEx);
+        };
+        bypass(rs1, operand1);
+        if (!current.has(DEC_ALU_IMM)) bypass(rs2, operand2);
+    }
+
+    executed = decodeToExecute;
+    executed.aluResult = current.isJump() ? static_cast<int32_t>(executed.programCounter + 4)
+                                          : aluCompute(current.aluOp, operand1, operand2);
+    if (current.has(DEC_MULDIV)) {
+        uint32_t latency = muldiv.issue(current.aluOp, operand1, currentCycleCount);
+        if (current.destMask) resultReady[current.destReg] = currentCycleCount + static_cast<int>(latency);
+    } else if (current.destMask) {
+        resultReady[current.destReg] = 0;
+    }
+
+    if constexpr (!Policy::resolveInDecode) {
+        if (current.branchKind != BRANCH_NONE) {
+            // Without resolveBranches every branch counts as not taken
+            executed.resolvedTaken = current.isJump() ||
+                                     (Policy::resolveBranches && branchTaken(current.branchOp, operand1, operand2));
+            executed.resolvedTarget = current.isJump() ? jumpTarget(current, executed.programCounter, operand1)
+                                                       : executed.programCounter + current.immediate;
+            // Resolved here, or marks the way to the `branch` sub-stage
+            if (depth.branchLatency == 1) {
+                resolveControl(executed, executed.resolvedTaken, executed.resolvedTarget, 0);
+            } else {
+                wrongPath = !predictedCorrectly(executed, executed.resolvedTaken, executed.resolvedTarget);
+            }
+        }
+    }
+    logStage(executed.programCounter, executed.sequence, Stage::EX);
 }
 
-void Processor::displayPipeline() {
-    std::vector<std::pair<uint32_t, std::string>> instructions;
-    for (const auto& [addr, data] : programMemory) {
-        instructions.emplace_back(addr, data.second); 
+template <typename Policy>
+void Processor<Policy>::accessMemory() {
+    // The later sub-stages first, carrying results on to WB;
+    // executeToWriteback[first + index] leaves MEM(index + 1)
+    const int first = depth.executeStages;
+    for (int index = depth.memoryStages - 1; index > 0; --index) {
+        PipelineStage& stage = executeToWriteback[first + index];
+        stage = executeToWriteback[first + index - 1];
+        if (stage.hasData) logStage(stage.programCounter, stage.sequence, Stage::MEM, false, index);
+    }
+
+    const PipelineStage& input = executeToWriteback[first - 1];
+    PipelineStage& accessed = executeToWriteback[first];
+    if (!input.hasData) {
+        accessed = PipelineStage();
+        return;
     }
-    std::sort(instructions.begin(), instructions.end());
 
-    for (const auto& [addr, text] : instructions) {
-        if (pipelineHistory.count(addr)) {
-            std::cout << text; 
-            const auto& stages = pipelineHistory[addr];
-            // Print stages for each cycle up to maxCycleLimit
-            for (int cycle = 0; cycle < maxCycleLimit; ++cycle) {
-                std::cout << ";";
-                std::cout << (cycle < static_cast<int>(stages.size()) ? stages[cycle] : "-");
+    const DecodedInstruction& current = *input.instruction;
+    uint32_t effectiveAddress = static_cast<uint32_t>(input.aluResult);
+    if (dcache.enabled() && (current.flags & (DEC_MEM_READ | DEC_MEM_WRITE))) {
+        if (!memoryReady(effectiveAddress, current.has(DEC_MEM_WRITE))) {
+            memoryStalled = true;
+            accessed = PipelineStage();
+            logStage(input.programCounter, input.sequence, Stage::MEM, true);
+            return;
+        }
+        memoryPending = false;
+    }
+    int32_t loaded = 0;
+    if (current.has(DEC_MEM_READ)) {
+        loaded = sharedMemory ? sharedMemory->load(effectiveAddress, current.memOp)
+                              : state.memory.load(effectiveAddress, current.memOp);
+    }
+    if (current.has(DEC_MEM_WRITE)) {
+        int32_t storeValue = state.registers[current.srcReg2];
+        if constexpr (Policy::forwarding) {
+            // MEM1's latch still holds the previous instruction at this point
+            updateScoreboard(first);
+            if (scoreboard.pendingIn(1u << current.srcReg2)) {
+                counters.forward(ForwardPath::MemWbToMem);
+                storeValue = scoreboard.value(current.srcReg2);
             }
-            std::cout << std::endl;
         }
+        if (sharedMemory) sharedMemory->store(effectiveAddress, current.memOp, storeValue);
+        else state.memory.store(effectiveAddress, current.memOp, storeValue);
+    }
+
+    accessed = input;
+    accessed.memoryData = loaded;
+    logStage(accessed.programCounter, accessed.sequence, Stage::MEM);
+}
+
+template <typename Policy>
+void Processor<Policy>::writeBackToRegisters() {
+    const PipelineStage& retiring = executeToWriteback.back();
+    if (!retiring.hasData) return;
+    counters.retire(program.index(retiring.programCounter));
+    const DecodedInstruction& current = *retiring.instruction;
+    if (current.destMask) {
+        state.registers[current.destReg] = current.has(DEC_MEM_READ) ? retiring.memoryData : retiring.aluResult;
+    }
+    logStage(retiring.programCounter, retiring.sequence, Stage::WB);
+    if (trace.isOpen()) trace.retire(currentCycleCount - firstCycle, retiring.sequence);
+}
+
+template <typename Policy>
+void Processor<Policy>::displayPipeline() {
+    pipelineHistory.write(*output, program.labels(), maxCycleLimit, Policy::diagram);
+}
+
+template <typename Policy>
+int runSimulator(int argc, char* argv[]) {
+    SimOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    if (const char* option = foreignOption(options, Policy::name)) {
+        std::cerr << "Error: " << option << " is not supported by " << Policy::name << "." << std::endl;
+        return 1;
     }
-}
\ No newline at end of file
+
+    Processor<Policy> simulator(options.depth);
+    return runWithOptions(simulator, options);
+}
+
+template class Processor<NoForwardingPolicy>;
+template class Processor<ForwardingPolicy>;
+template class Processor<NoForwardingDecodeBranchPolicy>;
+
+template int runSimulator<NoForwardingPolicy>(int, char*[]);
+template int runSimulator<ForwardingPolicy>(int, char*[]);
+template int runSimulator<NoForwardingDecodeBranchPolicy>(int, char*[]);
@@ -2,36 +2,165 @@
 #define PROCESSOR_HPP
 
 #include "structures.hpp"
+#include "policies.hpp"
+#include "program.hpp"
+#include "functional.hpp"
+#include "history.hpp"
+#include "stream.hpp"
+#include "trace.hpp"
+#include "checkpoint.hpp"
+#include "counters.hpp"
+#include "profile.hpp"
+#include "predictor.hpp"
+#include "cache.hpp"
+#include "muldiv.hpp"
+#include "coherence.hpp"
+#include "syscall.hpp"
+#include "scoreboard.hpp"
+#include "depth.hpp"
+#include <iostream>
 #include <vector>
 #include <string>
-#include <map>
-#include <utility>
-
-const uint32_t STOP_ADDRESS = 0xFFFFFFFF;
 
+// The five-stage pipeline shared by every simulator binary. Hazard
+// handling, branch resolution and diagram conventions come from `Policy`
+// (see policies.hpp); processor.cpp instantiates the supported policies.
+// IF, EX and MEM can each be split into sub-stages (see DepthConfig):
+//   - an instruction moves to the next fetch sub-stage once that one is
+//     free, and everything after ID moves on each cycle;
+//   - instructions compute in EX1 and access memory in MEM1, and their
+//     results can be bypassed once they leave the `alu` EX or `load` MEM
+//     sub-stage; hazards are checked against the producer's latch;
+//   - branches and jumps resolved in EX redirect fetch from the `branch`
+//     sub-stage and drop the instructions that followed them into EX.
+// The default depth is the classic five stages.
+template <typename Policy>
 class Processor {
 public:
-    Processor();
+    explicit Processor(const DepthConfig& depth = DepthConfig());
     void loadProgramFromFile(const std::string& filename);
+    // Advances the architectural state without timing (see runFunctional);
+    // the pipeline then starts empty at the resulting PC.
+    uint64_t fastForward(uint64_t maxInstructions, uint32_t untilPc = NO_STOP_PC);
+    uint32_t currentPc() const { return state.pc; }
+    // Fetch-side prediction; the default (none) always fetches PC + 4.
+    void setPredictor(const PredictorConfig& config) { predictor.configure(config); }
+    // L1 timing models in front of IF and MEM; disabled configs keep
+    // every access at one cycle.
+    void setCaches(const CacheConfig& instruction, const CacheConfig& data);
+    // Latencies of the RV32M unit in EX.
+    void setMulDiv(const MulDivConfig& config) { muldiv.configure(config); }
     void runSimulation(int totalCycles);
+    // runSimulation() in steps, for cores that run in lockstep quanta:
+    // startRun(), then runUntil() with increasing cycle counts, then
+    // finishRun(). runUntil() stops early once the program has ended.
+    void startRun(int totalCycles);
+    void runUntil(int cycles);
+    void finishRun();
+    // Makes this core `core` of a multi-core run: loads and stores go to
+    // `memory`, and D-cache accesses go through its coherence directory.
+    // Call before loading the program.
+    void attachSharedMemory(SharedMemory& memory, int core);
+    void setRegister(int index, int32_t value) { if (index != 0) state.registers[index] = value; }
     void displayPipeline();
+    // Where the diagram, run messages and the program's console output go;
+    // std::cout unless changed.
+    void setOutput(std::ostream& out) {
+        output = &out;
+        systemCalls.setConsole(out);
+    }
+    int simulatedCycles() const { return maxCycleLimit; }
+    uint64_t retiredInstructions() const { return counters.retired; }
+    const PerfCounters& perfCounters() const { return counters; }
+    void writeCounters(std::ostream& out) const;
+    // Charges every cycle of the next run to an instruction and a cause
+    // (see CycleProfile); writeProfile() prints the report, or the folded
+    // stacks with `folded`.
+    void setProfile(bool enabled) { profiling = enabled; }
+    void writeProfile(std::ostream& out, bool folded) const;
+    // Runs without keeping the diagram history, for long or timed runs.
+    void discardHistory() { keepHistory = false; }
+    // Keeps only part of the diagram history; call before loading the
+    // program.
+    void setWindow(const DiagramWindow& window) { diagramWindow = window; }
+    // Writes a cycle-major trace while running instead of keeping history.
+    void streamTo(const std::string& path);
+    // Writes a binary event trace (see trace.hpp) instead of keeping history.
+    void traceTo(const std::string& path);
+    // Complete simulator state: architectural state, latches and the hazard
+    // and redirect bookkeeping. A restored run continues the cycle count;
+    // its diagram starts at the restored cycle.
+    void saveCheckpoint(const std::string& path) const;
+    void loadCheckpoint(const std::string& path);
 
 private:
-    uint32_t programCounter;
-    std::vector<int32_t> registers; 
-    std::map<uint32_t, std::pair<uint32_t, std::string>> programMemory; 
+    const DepthConfig depth;
+    ArchState state;                   // PC, registers and data memory
+    Program program;                   // instructions and labels, indexed by program.index()
 
+    std::vector<PipelineStage> fetchLatches;  // after IF1..IF(n-1)
     PipelineStage fetchToDecode;
     PipelineStage decodeToExecute;
-    PipelineStage executeToMemory;
-    PipelineStage memoryToWriteback;
+    // After each EX and MEM sub-stage: [executeStages - 1] is EX/MEM and
+    // back() is MEM/WB
+    std::vector<PipelineStage> executeToWriteback;
+    Scoreboard scoreboard;             // writes in the latches above; see updateScoreboard()
 
-    std::map<uint32_t, std::vector<std::string>> pipelineHistory; 
+    PipelineHistory pipelineHistory; // rows indexed by program.index()
+    DiagramWindow diagramWindow;
+    std::ostream* output;
+    CycleStream cycleStream;
+    TraceWriter trace;
+    BranchPredictor predictor;
+    CacheModel icache;
+    CacheModel dcache;
+    MulDivUnit muldiv;
+    SystemCalls systemCalls;
+    bool keepHistory = true;
+    SharedMemory* sharedMemory = nullptr;  // multi-core runs only
+    int coreId = 0;
+    bool halted = false;             // the program ended during this run
+    uint32_t haltAddress = 0;        // of the ECALL or EBREAK that stopped the program
     int currentCycleCount;
+    int firstCycle = 0;              // cycle of the first diagram column
     int maxCycleLimit;
+    PerfCounters counters;           // reset by each runSimulation()
+    bool profiling = false;
+    CycleProfile profile;            // reset by each runSimulation() when profiling
+
+    bool pausePipeline = false;      // ID held its instruction this cycle
+    int redirectCycle = -1;          // cycle in which fetch moves to redirectTarget
+    uint32_t redirectTarget = 0;
+    uint32_t redirectSource = 0;     // the branch or jump that asked for it
+    CycleCause redirectCause = CycleCause::TakenBranch;
+    uint32_t lastPassedAddress = 0;  // last instruction ID passed on
+    // A branch or jump in EX will redirect fetch once it reaches the
+    // `branch` sub-stage; what enters EX1 behind it is not executed
+    bool wrongPath = false;
+
+    uint64_t nextSequence = 1;       // for PipelineStage::sequence
+    uint64_t fetchSequence = 0;      // instruction IF is still working on, 0 once latched
+    uint32_t fetchSequenceAddress = 0;
 
-    bool pausePipeline = false; 
-    bool clearFetchDecode = false; 
+    // Cache accesses in progress. The wait counts include the current cycle.
+    bool memoryStalled = false;      // MEM held its instruction this cycle
+    bool fetchPending = false;
+    uint32_t fetchPendingAddress = 0;
+    uint32_t fetchWaitCycles = 0;
+    bool memoryPending = false;      // for the instruction entering MEM1
+    uint32_t memoryWaitCycles = 0;
+
+    // First cycle in which each register's pending RV32M result can be
+    // forwarded to EX; stale entries are in the past.
+    int resultReady[32] = {};
+
+    // Last instruction drawn in each sub-stage before WB, for
+    // Policy::repeatAsStall
+    struct LoggedStage {
+        uint32_t address = 0;
+        int cycle = -2;
+    };
+    LoggedStage lastLogged[3 * MAX_SUBSTAGES + 1];
 
     // Core pipeline functions
     void fetchInstruction();
@@ -40,10 +169,34 @@ private:
     void accessMemory();
     void writeBackToRegisters();
 
-    InstructionDetails interpretInstruction(uint32_t machineCode, uint32_t address);
+    bool isProgramAddress(uint32_t address) const;
     void setupRegisters(uint32_t stackPointer = 0x7ffffff0, uint32_t globalPointer = 0x10000000);
-    void logStage(uint32_t address, const std::string& stageName);
-    bool hasDataHazard(const InstructionDetails& currentInstruction);
+    // `index` is the sub-stage of a split stage, from 0
+    void logStage(uint32_t address, uint64_t sequence, Stage stage, bool held = false, int index = 0);
+    uint64_t fetchInstance(uint32_t address);
+    void squash(PipelineStage& stage);
+    void updateScoreboard(int from);
+    StallCause dataHazard(const DecodedInstruction& currentInstruction) const;
+    StallCause mulDivHazard(const DecodedInstruction& currentInstruction, int& cycles) const;
+    void executeSystem(const PipelineStage& stage);
+    void resolveInDecode(const PipelineStage& stage);
+    bool bypassedFromMemory(int reg) const;
+    int32_t decodeOperand(uint8_t reg);
+    uint32_t jumpTarget(const DecodedInstruction& current, uint32_t address, int32_t base) const;
+    void redirect(uint32_t target, int delay);
+    void profileEmptyDecode();
+    bool fetchReady(uint32_t address);
+    bool memoryReady(uint32_t address, bool write);
+    int idleCycles() const;
+    void skipIdleCycles(int cycles);
+    bool resolveControl(const PipelineStage& stage, bool taken, uint32_t target, int delay);
+    void saveStage(CheckpointWriter& out, const PipelineStage& stage) const;
+    void loadStage(CheckpointReader& in, PipelineStage& stage);
 };
 
-#endif
\ No newline at end of file
+// Parses the command line and runs one simulation with `Policy`; the body
+// of every simulator's main().
+template <typename Policy>
+int runSimulator(int argc, char* argv[]);
+
+#endif
@@ -0,0 +1,121 @@
+#include "profile.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+static const char* const CYCLE_NAMES[] = {"useful", "taken_branch", "flush", "fetch", "drain"};
+
+static const char* causeName(int cause) {
+    int stall = cause - static_cast<int>(CycleCause::Count);
+    return stall < 0 ? CYCLE_NAMES[cause] : stallCauseName(static_cast<StallCause>(stall));
+}
+
+// "0000000c: beq x6 x0 12", or the label of a binary's instruction, which
+// already starts with the address; semicolons, which separate frames in
+// folded stacks, become commas.
+static std::string instructionText(const Program& program, size_t row) {
+    std::string text = program.label(row);
+    if (!program.assemblyText.empty()) {
+        char address[16];
+        std::snprintf(address, sizeof(address), "%08x: ", static_cast<unsigned>(program.base + row * 4));
+        text.insert(0, address);
+    }
+    std::replace(text.begin(), text.end(), ';', ',');
+    return text;
+}
+
+static std::string percent(uint64_t part, uint64_t whole) {
+    char text[16];
+    std::snprintf(text, sizeof(text), "%.1f%%", whole ? 100.0 * static_cast<double>(part) / whole : 0.0);
+    return text;
+}
+
+void CycleProfile::writeReport(std::ostream& out, const char* engine, const Program& program, uint64_t cycles,
+                               uint64_t retired) const {
+    char line[160];
+    std::snprintf(line, sizeof(line), "Cycle profile (%s): %llu cycles, %llu instructions retired", engine,
+                  static_cast<unsigned long long>(cycles), static_cast<unsigned long long>(retired));
+    out << line;
+    if (retired) {
+        std::snprintf(line, sizeof(line), ", CPI %.3f", static_cast<double>(cycles) / retired);
+        out << line;
+    }
+    out << "\n\nBy cause:\n";
+
+    Counts byCause{};
+    std::vector<std::pair<uint64_t, size_t>> order;  // (cycles, row) of every row charged
+    for (size_t row = 0; row < rows.size(); ++row) {
+        uint64_t total = 0;
+        for (int cause = 0; cause < CAUSES; ++cause) {
+            byCause[cause] += rows[row][cause];
+            total += rows[row][cause];
+        }
+        if (total) order.push_back({total, row});
+    }
+    for (int cause = 0; cause < CAUSES; ++cause) {
+        if (!byCause[cause]) continue;
+        std::snprintf(line, sizeof(line), "  %-16s %12llu %7s\n", causeName(cause),
+                      static_cast<unsigned long long>(byCause[cause]), percent(byCause[cause], cycles).c_str());
+        out << line;
+    }
+
+    // Most cycles first; equal counts in program order
+    std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    size_t width = 11;
+    for (const auto& [total, row] : order) width = std::max(width, instructionText(program, row).size());
+    width = std::min<size_t>(width, 48);
+
+    out << "\nBy instruction:\n";
+    std::snprintf(line, sizeof(line), "  %12s %7s  %-*s  %s\n", "cycles", "share", static_cast<int>(width),
+                  "instruction", "causes");
+    out << line;
+    for (const auto& [total, row] : order) {
+        std::snprintf(line, sizeof(line), "  %12llu %7s  ", static_cast<unsigned long long>(total),
+                      percent(total, cycles).c_str());
+        std::string text = instructionText(program, row);
+        text.resize(std::max(text.size(), width), ' ');
+        out << line << text << ' ';
+
+        // Its causes, most cycles first
+        std::vector<std::pair<uint64_t, int>> causes;
+        for (int cause = 0; cause < CAUSES; ++cause) {
+            if (rows[row][cause]) causes.push_back({rows[row][cause], cause});
+        }
+        std::stable_sort(causes.begin(), causes.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (const auto& [count, cause] : causes) out << ' ' << causeName(cause) << '=' << count;
+        out << '\n';
+    }
+}
+
+void CycleProfile::writeFolded(std::ostream& out, const Program& program) const {
+    // A block starts at the entry, at a branch or jump target and after a
+    // branch, jump, ECALL or EBREAK
+    std::vector<bool> leader(rows.size() + 1, false);
+    if (!rows.empty()) leader[0] = true;
+    if (program.contains(program.entry)) leader[program.index(program.entry)] = true;
+    for (size_t row = 0; row < rows.size(); ++row) {
+        const DecodedInstruction& instruction = program.instructions[row];
+        if (instruction.branchKind == BRANCH_NONE && instruction.system == SYSTEM_NONE) continue;
+        leader[row + 1] = true;
+        if (instruction.branchKind == BRANCH_CONDITIONAL || instruction.branchKind == BRANCH_JAL) {
+            uint32_t target = program.base + static_cast<uint32_t>(row * 4) + instruction.immediate;
+            if (program.contains(target)) leader[program.index(target)] = true;
+        }
+    }
+
+    char block[24] = "";
+    for (size_t row = 0; row < rows.size(); ++row) {
+        if (leader[row]) {
+            std::snprintf(block, sizeof(block), "block %08x", static_cast<unsigned>(program.base + row * 4));
+        }
+        std::string frames;
+        for (int cause = 0; cause < CAUSES; ++cause) {
+            if (!rows[row][cause]) continue;
+            if (frames.empty()) frames = std::string(block) + ';' + instructionText(program, row) + ';';
+            out << frames << causeName(cause) << ' ' << rows[row][cause] << '\n';
+        }
+    }
+}
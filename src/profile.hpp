@@ -0,0 +1,62 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include "counters.hpp"
+#include "program.hpp"
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// What a cycle went on when ID did not hold its instruction for a
+// StallCause.
+enum class CycleCause : uint8_t {
+    Useful = 0,   // ID passed the instruction on
+    TakenBranch,  // the fall-through fetched behind a taken branch or jump was dropped
+    Flush,        // an instruction fetched on a wrong prediction was dropped
+    Fetch,        // IF had nothing ready for ID, e.g. on an I-cache miss
+    Drain,        // fetch has stopped at the end of the program
+    Count
+};
+
+// Where the cycles of a run went, per instruction (see --profile). Every
+// cycle is charged to one program row and one cause from ID's point of
+// view, so the counts add up to the run's cycles:
+//   - the instruction ID passes on, as useful work;
+//   - the instruction ID holds, with the StallCause it waits on;
+//   - the branch or jump that redirected fetch, when ID is empty because
+//     the instruction behind it was dropped;
+//   - the instruction IF is fetching, when ID is empty because IF had
+//     nothing ready;
+//   - the last instruction ID passed on, once fetch has stopped.
+class CycleProfile {
+public:
+    // Starts counting for `rowCount` instructions; an empty profile
+    // ignores every charge.
+    void reset(size_t rowCount) { rows.assign(rowCount, {}); }
+    bool enabled() const { return !rows.empty(); }
+
+    void charge(size_t row, CycleCause cause, uint64_t cycles = 1) {
+        if (row < rows.size()) rows[row][static_cast<int>(cause)] += cycles;
+    }
+    void charge(size_t row, StallCause cause, uint64_t cycles = 1) {
+        if (row < rows.size()) rows[row][static_cast<int>(CycleCause::Count) + static_cast<int>(cause)] += cycles;
+    }
+
+    // The totals by cause, then every instruction that was charged, most
+    // cycles first, with its cycles by cause.
+    void writeReport(std::ostream& out, const char* engine, const Program& program, uint64_t cycles,
+                     uint64_t retired) const;
+    // One "block;instruction;cause cycles" line per instruction and cause,
+    // for flame graph tools. Blocks are the program's static basic blocks,
+    // named by their first address.
+    void writeFolded(std::ostream& out, const Program& program) const;
+
+private:
+    static constexpr int CAUSES = static_cast<int>(CycleCause::Count) + static_cast<int>(StallCause::Count);
+    using Counts = std::array<uint64_t, CAUSES>;
+
+    std::vector<Counts> rows;
+};
+
+#endif
@@ -0,0 +1,223 @@
+#include "program.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Read-only mapping of a whole file, released with the last Program copy.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Could not open file: " + filename);
+        struct stat info {};
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw std::runtime_error("Could not read file: " + filename);
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Could not map file: " + filename);
+            }
+            bytes = static_cast<const uint8_t*>(mapped);
+        }
+        close(fd);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        if (bytes) munmap(const_cast<uint8_t*>(bytes), length);
+    }
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+};
+
+// ELF32 fields used by the loader, at their file offsets
+const size_t ELF_HEADER_SIZE = 52;
+const size_t PROGRAM_HEADER_SIZE = 32;
+const uint16_t ELF_TYPE_EXEC = 2;
+const uint16_t ELF_MACHINE_RISCV = 243;
+const uint32_t SEGMENT_LOAD = 1;
+const uint32_t SEGMENT_EXECUTE = 1;
+const uint32_t MAX_CODE_BYTES = 64u << 20;
+
+uint16_t read16(const uint8_t* bytes) {
+    return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+uint32_t read32(const uint8_t* bytes) {
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+           (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+bool isElf(const MappedFile& file) {
+    return file.size() >= 4 && std::memcmp(file.data(), "\x7f" "ELF", 4) == 0;
+}
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Predecodes the words of [address, address + length) over the zero words
+// the code range starts with.
+void predecodeRange(Program& program, uint32_t address, const uint8_t* bytes, uint32_t length) {
+    for (uint32_t offset = 0; offset + 4 <= length; offset += 4) {
+        size_t index = program.index(address + offset);
+        program.instructions[index] = predecode(read32(bytes + offset), address + offset);
+    }
+}
+
+void loadElf(Program& program, const MappedFile& file, const std::string& filename) {
+    auto malformed = [&](const std::string& why) {
+        return std::runtime_error("Not a loadable RV32 executable (" + why + "): " + filename);
+    };
+    const uint8_t* bytes = file.data();
+    if (file.size() < ELF_HEADER_SIZE) throw malformed("truncated header");
+    if (bytes[4] != 1 || bytes[5] != 1) throw malformed("not 32-bit little-endian");
+    if (read16(bytes + 16) != ELF_TYPE_EXEC) throw malformed("not an executable");
+    if (read16(bytes + 18) != ELF_MACHINE_RISCV) throw malformed("not RISC-V");
+
+    uint32_t entry = read32(bytes + 24);
+    uint32_t headerOffset = read32(bytes + 28);
+    uint16_t headerSize = read16(bytes + 42);
+    uint16_t headerCount = read16(bytes + 44);
+    if (headerSize < PROGRAM_HEADER_SIZE ||
+        headerOffset + static_cast<uint64_t>(headerSize) * headerCount > file.size()) {
+        throw malformed("bad program headers");
+    }
+
+    std::vector<MemorySegment> code;
+    uint32_t codeStart = UINT32_MAX;
+    uint32_t codeEnd = 0;
+    for (uint16_t i = 0; i < headerCount; ++i) {
+        const uint8_t* header = bytes + headerOffset + static_cast<size_t>(i) * headerSize;
+        if (read32(header) != SEGMENT_LOAD) continue;
+
+        MemorySegment segment;
+        uint32_t fileOffset = read32(header + 4);
+        segment.address = read32(header + 8);
+        segment.fileSize = read32(header + 16);
+        segment.memorySize = read32(header + 20);
+        if (static_cast<uint64_t>(fileOffset) + segment.fileSize > file.size() ||
+            segment.fileSize > segment.memorySize ||
+            static_cast<uint64_t>(segment.address) + segment.memorySize > (uint64_t(1) << 32)) {
+            throw malformed("segment " + std::to_string(i) + " out of range");
+        }
+        segment.bytes = bytes + fileOffset;
+        program.segments.push_back(segment);
+
+        if ((read32(header + 24) & SEGMENT_EXECUTE) && segment.fileSize > 0) {
+            code.push_back(segment);
+            codeStart = std::min(codeStart, segment.address);
+            codeEnd = std::max(codeEnd, segment.address + segment.fileSize);
+        }
+    }
+    if (codeStart == UINT32_MAX) throw malformed("no executable segment");
+    if ((codeStart & 3) != 0) throw malformed("code not word aligned");
+    if (codeEnd - codeStart > MAX_CODE_BYTES) throw malformed("code spans more than 64 MiB");
+
+    program.base = codeStart;
+    program.entry = entry;
+    program.instructions.assign((codeEnd - codeStart) / 4, predecode(0, 0));
+    for (const MemorySegment& segment : code) {
+        predecodeRange(program, segment.address, segment.bytes, segment.fileSize);
+    }
+}
+
+void loadFlatBinary(Program& program, const MappedFile& file) {
+    if (file.size() > MAX_CODE_BYTES) {
+        throw std::runtime_error("Flat binary larger than 64 MiB");
+    }
+    uint32_t length = static_cast<uint32_t>(file.size());
+    program.instructions.resize(length / 4);
+    predecodeRange(program, 0, file.data(), length);
+    program.segments.push_back({0, file.data(), length, length});
+}
+
+bool isBlank(const std::string& line) {
+    return line.find_first_not_of(" \t\r\n") == std::string::npos;
+}
+
+void loadListing(Program& program, const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    std::string line;
+    uint32_t address = 0;
+
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        int lineNumber;
+        uint32_t machineCode;
+        std::string assembly;
+
+        if (!(ss >> lineNumber) || !(ss >> std::hex >> machineCode)) {
+            if (!isBlank(line)) {
+                std::cerr << "Warning: Skipping invalid line: \"" << line << "\"" << std::endl;
+            }
+            continue;
+        }
+
+        std::getline(ss, assembly);
+        assembly.erase(0, assembly.find_first_not_of(" \t"));
+        assembly.erase(assembly.find_last_not_of(" \t\r") + 1);
+        if (assembly.empty()) {
+            assembly = "NOP";
+        }
+
+        program.instructions.push_back(predecode(machineCode, address));
+        program.assemblyText.push_back(assembly);
+        address += 4;
+    }
+}
+
+} // namespace
+
+std::string Program::label(size_t index) const {
+    if (index < assemblyText.size()) return assemblyText[index];
+    char text[24];
+    std::snprintf(text, sizeof(text), "%08x: %08x", static_cast<unsigned>(base + index * 4),
+                  static_cast<unsigned>(instructions[index].machineCode));
+    return text;
+}
+
+std::vector<std::string> Program::labels() const {
+    if (!assemblyText.empty()) return assemblyText;
+    std::vector<std::string> result;
+    result.reserve(size());
+    for (size_t index = 0; index < size(); ++index) result.push_back(label(index));
+    return result;
+}
+
+Program loadProgram(const std::string& filename) {
+    Program program;
+    auto file = std::make_shared<MappedFile>(filename);
+    if (isElf(*file)) {
+        loadElf(program, *file, filename);
+    } else if (endsWith(filename, ".bin")) {
+        loadFlatBinary(program, *file);
+    } else {
+        loadListing(program, filename);
+        return program;
+    }
+    program.image = file;
+    return program;
+}
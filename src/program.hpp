@@ -0,0 +1,51 @@
+#ifndef PROGRAM_HPP
+#define PROGRAM_HPP
+
+#include "decoder.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Part of the initial memory image: `fileSize` bytes copied to `address`;
+// the rest of `memorySize` stays zero.
+struct MemorySegment {
+    uint32_t address = 0;
+    const uint8_t* bytes = nullptr;
+    uint32_t fileSize = 0;
+    uint32_t memorySize = 0;
+};
+
+// A loaded program: one predecoded record per instruction word, indexed by
+// (address - base) / 4. Text listings also carry a diagram label per
+// instruction; binaries get theirs from label() when a diagram is written.
+struct Program {
+    std::vector<DecodedInstruction> instructions;
+    std::vector<std::string> assemblyText;  // empty for binaries
+    uint32_t base = 0;                      // address of instructions[0]
+    uint32_t entry = 0;                     // initial PC
+    std::vector<MemorySegment> segments;    // binaries only
+    std::shared_ptr<const void> image;      // keeps the segment bytes mapped
+
+    bool empty() const { return instructions.empty(); }
+    size_t size() const { return instructions.size(); }
+    // Addresses below base wrap to indices past the end
+    size_t index(uint32_t address) const { return (address - base) / 4; }
+    bool contains(uint32_t address) const { return (address & 3) == 0 && index(address) < size(); }
+    std::string label(size_t index) const;
+    std::vector<std::string> labels() const;
+};
+
+// Loads a program, picking the format from the file:
+//   - RV32 little-endian ELF executables (by their magic number): every
+//     PT_LOAD segment becomes part of the memory image, the executable ones
+//     are predecoded, and execution starts at e_entry
+//   - flat binaries (*.bin): the whole file is loaded at address 0 as both
+//     code and initial data
+//   - anything else is a "<line> <hex> <assembly...>" listing; lines that
+//     do not parse are reported on stderr and skipped
+// Binaries are read through mmap, with no allocation per instruction.
+// Throws std::runtime_error if the file cannot be opened or is malformed.
+Program loadProgram(const std::string& filename);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SCOREBOARD_HPP
+#define SCOREBOARD_HPP
+
+#include "structures.hpp"
+#include <cstdint>
+
+// Register writes still on their way to WB, for hazard checks and bypass
+// selection that take the same few mask operations however many latches
+// there are: a mask of the registers with a pending result, a mask of
+// those whose youngest writer is a load, and a table of those writers and
+// the latches they are in. Latches are numbered from the one after EX1 and
+// added oldest first, so a younger write to a register replaces an older
+// one.
+class Scoreboard {
+public:
+    void clear() {
+        pending = 0;
+        loads = 0;
+    }
+
+    // Adds the write of the instruction in `latch`, number `position`.
+    void add(int position, const PipelineStage& latch) {
+        uint32_t written = latch.hasData ? latch.instruction->destMask : 0;
+        if (!written) return;
+        pending |= written;
+        loads = latch.instruction->has(DEC_MEM_READ) ? loads | written : loads & ~written;
+        producers[latch.instruction->destReg] = &latch;
+        positions[latch.instruction->destReg] = static_cast<uint8_t>(position);
+    }
+
+    // The registers of `registers` with a pending write; whose youngest
+    // writer is a load.
+    uint32_t pendingIn(uint32_t registers) const { return registers & pending; }
+    uint32_t loadsIn(uint32_t registers) const { return registers & loads; }
+
+    // The latch of the youngest writer of pending register `reg`.
+    int position(int reg) const { return positions[reg]; }
+    // What the youngest writer of pending register `reg` will write back.
+    int32_t value(int reg) const {
+        const PipelineStage& producer = *producers[reg];
+        return producer.instruction->has(DEC_MEM_READ) ? producer.memoryData : producer.aluResult;
+    }
+
+private:
+    uint32_t pending = 0;
+    uint32_t loads = 0;
+    const PipelineStage* producers[32] = {};
+    uint8_t positions[32] = {};
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Measures simulator throughput:
+//
+//     simbench [--cycles <n>] [--runs <n>] [--engine <binary>]... <inputfile>...
+//
+// Every program is run for the given number of cycles under each engine
+// binary (./forward and ./noforward unless --engine is given) with
+// --summary, each run in its own process so peak RSS belongs to that run
+// alone. The fastest of --runs repetitions is reported, one line per
+// program and engine:
+//
+//     program;engine;cycles;instructions;seconds;cycles_per_sec;instructions_per_sec;peak_rss_kib
+
+struct Measurement {
+    long long cycles = 0;
+    long long instructions = 0;
+    double seconds = 0;
+    long peakRssKib = 0;
+};
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--cycles <n>] [--runs <n>] [--engine <binary>]... <inputfile>..."
+              << std::endl;
+}
+
+// Runs `engine program cycles --summary` and parses its summary line.
+static bool measure(const std::string& engine, const std::string& program, long long cycles,
+                    Measurement& result) {
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) {
+        std::perror("pipe");
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t child = fork();
+    if (child < 0) {
+        std::perror("fork");
+        return false;
+    }
+    if (child == 0) {
+        dup2(pipeFds[1], STDOUT_FILENO);
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        std::string cycleArg = std::to_string(cycles);
+        execl(engine.c_str(), engine.c_str(), program.c_str(), cycleArg.c_str(), "--summary",
+              static_cast<char*>(nullptr));
+        std::perror(engine.c_str());
+        _exit(127);
+    }
+
+    close(pipeFds[1]);
+    std::string output;
+    char buffer[4096];
+    ssize_t count;
+    while ((count = read(pipeFds[0], buffer, sizeof(buffer))) > 0) {
+        output.append(buffer, static_cast<size_t>(count));
+    }
+    close(pipeFds[0]);
+
+    int status = 0;
+    struct rusage usage {};
+    wait4(child, &status, 0, &usage);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.peakRssKib = usage.ru_maxrss;  // kilobytes on Linux
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "Error: " << engine << " " << program << " failed." << std::endl;
+        return false;
+    }
+
+    size_t line = output.rfind("Simulated ");
+    if (line == std::string::npos ||
+        std::sscanf(output.c_str() + line, "Simulated %lld cycles, retired %lld instructions.",
+                    &result.cycles, &result.instructions) != 2) {
+        std::cerr << "Error: No summary from " << engine << " " << program << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    long long cycles = 10000000;
+    int runs = 1;
+    std::vector<std::string> engines;
+    std::vector<std::string> programs;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--cycles" || arg == "--runs" || arg == "--engine") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (arg == "--engine") {
+                engines.push_back(value);
+                continue;
+            }
+            try {
+                long long number = std::stoll(value);
+                if (number <= 0) throw std::invalid_argument(value);
+                if (arg == "--cycles") cycles = number;
+                else runs = static_cast<int>(number);
+            } catch (const std::exception&) {
+                std::cerr << "Error: Invalid value '" << value << "' for " << arg << "." << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--", 0) != 0) {
+            programs.push_back(arg);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (programs.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (engines.empty()) {
+        engines = {"./forward", "./noforward"};
+    }
+
+    int failed = 0;
+    std::cout << "program;engine;cycles;instructions;seconds;cycles_per_sec;instructions_per_sec;peak_rss_kib"
+              << std::endl;
+    for (const std::string& program : programs) {
+        for (const std::string& engine : engines) {
+            Measurement best;
+            bool ok = true;
+            for (int run = 0; run < runs && ok; ++run) {
+                Measurement current;
+                ok = measure(engine, program, cycles, current);
+                if (ok && (run == 0 || current.seconds < best.seconds)) best = current;
+            }
+            if (!ok) {
+                ++failed;
+                continue;
+            }
+            std::cout << program << ";" << engine << ";" << best.cycles << ";" << best.instructions << ";"
+                      << best.seconds << ";" << static_cast<long long>(best.cycles / best.seconds) << ";"
+                      << static_cast<long long>(best.instructions / best.seconds) << ";" << best.peakRssKib
+                      << std::endl;
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}
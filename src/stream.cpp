@@ -0,0 +1,108 @@
+#include "stream.hpp"
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+CycleStream::~CycleStream() {
+    close();
+}
+
+void CycleStream::open(const std::string& path, int width, const DepthConfig& depth) {
+    close();
+    slots = width;
+    stages = depth;
+    if (path == "-") {
+        file = stdout;
+        ownsFile = false;
+    } else {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) throw std::runtime_error("Could not open stream file: " + path);
+        ownsFile = true;
+    }
+    buffer.resize(BUFFER_SIZE);
+    used = 0;
+    std::string header = "cycle";
+    for (Stage stage : {Stage::IF, Stage::ID, Stage::EX, Stage::MEM, Stage::WB}) {
+        for (int index = 0; index < depth.stages(stage); ++index) {
+            header += ';';
+            header += stageName(stage);
+            if (uint8_t label = depth.label(stage, index)) header += static_cast<char>('0' + label);
+        }
+    }
+    header += ";stall;flush\n";
+    append(header.data(), header.size());
+}
+
+void CycleStream::close() {
+    if (!file) return;
+    drain();
+    std::fflush(file);
+    if (ownsFile) std::fclose(file);
+    file = nullptr;
+    ownsFile = false;
+}
+
+void CycleStream::beginCycle(uint32_t currentCycle) {
+    cycle = currentCycle;
+    std::memset(occupied, 0, sizeof(occupied));
+    stalled = false;
+    flushed = false;
+}
+
+void CycleStream::occupy(Stage stage, uint32_t address, int slot, int index) {
+    if (stage < Stage::IF || stage > Stage::WB || index < 0 || index >= stages.stages(stage)) return;
+    if (slot < 0 || slot >= slots) return;
+    int column = stages.column(stage, index);
+    addresses[column][slot] = address;
+    occupied[column] |= static_cast<uint8_t>(1u << slot);
+}
+
+void CycleStream::endCycle() {
+    // Longest line: 10-digit cycle + MAX_COLUMNS * MAX_ISSUE_WIDTH * "|0x" + 8
+    // hex digits + ";0;0\n"
+    char line[10 + MAX_COLUMNS * MAX_ISSUE_WIDTH * 11 + 8];
+    char* out = line;
+
+    char digits[10];
+    int count = 0;
+    uint32_t value = cycle;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (count > 0) *out++ = digits[--count];
+
+    static const char hex[] = "0123456789abcdef";
+    for (int column = 0; column < stages.columns(); ++column) {
+        for (int slot = 0; slot < slots; ++slot) {
+            *out++ = slot ? '|' : ';';
+            if (!(occupied[column] & (1u << slot))) {
+                *out++ = '-';
+                continue;
+            }
+            *out++ = '0';
+            *out++ = 'x';
+            for (int shift = 28; shift >= 0; shift -= 4) {
+                *out++ = hex[(addresses[column][slot] >> shift) & 0xF];
+            }
+        }
+    }
+    *out++ = ';';
+    *out++ = stalled ? '1' : '0';
+    *out++ = ';';
+    *out++ = flushed ? '1' : '0';
+    *out++ = '\n';
+    append(line, out - line);
+}
+
+void CycleStream::append(const char* text, size_t length) {
+    if (used + length > buffer.size()) drain();
+    std::memcpy(buffer.data() + used, text, length);
+    used += length;
+}
+
+void CycleStream::drain() {
+    if (used == 0) return;
+    std::fwrite(buffer.data(), 1, used, file);
+    used = 0;
+}
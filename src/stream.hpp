@@ -0,0 +1,65 @@
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include "depth.hpp"
+#include "history.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Cycle-major pipeline trace written while the simulation runs. Each
+// cycle becomes one line
+//
+//     cycle;IF;ID;EX;MEM;WB;stall;flush
+//
+// where each stage column holds the PC of the instruction that occupied
+// the stage that cycle (0x-prefixed hex) or "-" when it was empty. In a
+// wide pipeline a column lists every slot of the stage, joined by '|', and
+// a stage split into sub-stages gets a column for each (IF1;IF2;...). Output
+// goes through a large private buffer, so memory use is constant no
+// matter how long the run is. The path "-" selects stdout, and a named
+// pipe works like any other file.
+class CycleStream {
+public:
+    CycleStream() = default;
+    CycleStream(const CycleStream&) = delete;
+    CycleStream& operator=(const CycleStream&) = delete;
+    ~CycleStream();
+
+    // `width` is the number of slots per stage and `depth` says how the
+    // stages are split; throws std::runtime_error.
+    void open(const std::string& path, int width = 1, const DepthConfig& depth = DepthConfig());
+    bool isOpen() const { return file != nullptr; }
+    void close();
+
+    // `cycle` is one-based, matching the diagram columns.
+    void beginCycle(uint32_t cycle);
+    // `index` is the sub-stage of a split stage, from 0.
+    void occupy(Stage stage, uint32_t address, int slot = 0, int index = 0);
+    void markStall() { stalled = true; }
+    void markFlush() { flushed = true; }
+    void endCycle();
+
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+    static constexpr int MAX_COLUMNS = 3 * MAX_SUBSTAGES + 2;
+
+    FILE* file = nullptr;
+    bool ownsFile = false;
+    std::vector<char> buffer;
+    size_t used = 0;
+
+    int slots = 1;
+    DepthConfig stages;
+    uint32_t cycle = 0;
+    uint32_t addresses[MAX_COLUMNS][MAX_ISSUE_WIDTH];
+    uint8_t occupied[MAX_COLUMNS];  // bit per slot
+    bool stalled = false;
+    bool flushed = false;
+
+    void append(const char* text, size_t length);
+    void drain();
+};
+
+#endif
@@ -1,36 +1,20 @@
 #ifndef STRUCTURES_HPP
 #define STRUCTURES_HPP
 
+#include "decoder.hpp"
 #include <cstdint>
-#include <string>
-
-struct InstructionDetails {
-    uint32_t machineCode = 0x00000013; 
-    uint32_t programCounter = 0;
-    std::string assemblyText = "NOP"; 
-
-    uint32_t opcode = 0x13; 
-    uint32_t destReg = 0; 
-    uint32_t func3 = 0;   
-    uint32_t srcReg1 = 0;  
-    uint32_t srcReg2 = 0;  
-    uint32_t func7 = 0;   
-    int32_t immediate = 0; 
-
-    bool isJump = false;    // True for JAL/JALR (unconditional jumps)
-    bool readsMemory = false;  // True for load instructions (e.g., lw)
-    bool writesMemory = false; // True for store instructions (e.g., sw)
-    bool writesRegister = false; // True if instruction updates a register
-
-    bool isEmpty = false;   // Marks this as a pipeline bubble
-
-    InstructionDetails() : isEmpty(true) {}
-    explicit InstructionDetails(bool empty) : isEmpty(empty) {}
-};
 
 struct PipelineStage {
-    InstructionDetails instruction;
+    const DecodedInstruction* instruction = nullptr; // predecoded record, null for a bubble
+    uint32_t programCounter = 0;
     bool hasData = false;
+    int32_t aluResult = 0;   // from EX on: ALU result, effective address or link value
+    int32_t memoryData = 0;  // MEM/WB only: the loaded value
+    bool predictedTaken = false;  // what IF assumed when choosing the next fetch
+    uint32_t predictedTarget = 0;
+    bool resolvedTaken = false;   // a branch or jump from EX1 to the sub-stage that resolves it:
+    uint32_t resolvedTarget = 0;  // where it goes, as computed in EX1
+    uint64_t sequence = 0;   // fetch order from 1, naming the instance in traces; 0 for a bubble
 };
 
-#endif
\ No newline at end of file
+#endif
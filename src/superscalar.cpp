@@ -0,0 +1,5 @@
+#include "wide.hpp"
+
+int main(int argc, char* argv[]) {
+    return runSuperscalar(argc, argv);
+}
@@ -0,0 +1,93 @@
+#include "syscall.hpp"
+#include <algorithm>
+
+static const int A0 = 10, A1 = 11, A2 = 12, A7 = 17;
+static const int32_t ERROR_BAD_FILE = -9;        // EBADF
+static const int32_t ERROR_NOT_SUPPORTED = -38;  // ENOSYS
+static const uint64_t CYCLES_PER_SECOND = 1000000000;
+// Longest read or write, as in Linux, so the byte count fits the result
+static const uint32_t MAX_TRANSFER = 0x7FFFF000;
+
+uint32_t initialBreak(const Program& program) {
+    uint64_t end = program.base + program.size() * 4;
+    for (const MemorySegment& segment : program.segments) {
+        end = std::max<uint64_t>(end, static_cast<uint64_t>(segment.address) + segment.memorySize);
+    }
+    end = (end + DataMemory::PAGE_SIZE - 1) & ~static_cast<uint64_t>(DataMemory::PAGE_SIZE - 1);
+    return static_cast<uint32_t>(std::min<uint64_t>(end, 0xFFFFF000));
+}
+
+// Fills a timespec or timeval: 64-bit seconds, then the remainder in
+// units of `fraction` per second.
+static void writeTime(DataMemory& memory, uint32_t address, uint64_t cycle, uint64_t fraction) {
+    uint64_t seconds = cycle / CYCLES_PER_SECOND;
+    uint64_t rest = cycle % CYCLES_PER_SECOND * fraction / CYCLES_PER_SECOND;
+    memory.store32(address, static_cast<uint32_t>(seconds));
+    memory.store32(address + 4, static_cast<uint32_t>(seconds >> 32));
+    memory.store32(address + 8, static_cast<uint32_t>(rest));
+}
+
+void SystemCalls::call(ArchState& state, int32_t* registers, DataMemory& memory, uint64_t cycle) {
+    uint32_t number = static_cast<uint32_t>(registers[A7]);
+    uint32_t argument0 = static_cast<uint32_t>(registers[A0]);
+    uint32_t argument1 = static_cast<uint32_t>(registers[A1]);
+    uint32_t argument2 = static_cast<uint32_t>(registers[A2]);
+    int32_t result = 0;
+
+    switch (number) {
+        case SYS_READ: {
+            if (argument0 != 0) {
+                result = ERROR_BAD_FILE;
+                break;
+            }
+            uint32_t count = 0;
+            uint32_t limit = std::min(argument2, MAX_TRANSFER);
+            for (int c; count < limit && (c = std::cin.get()) != EOF;) {
+                memory.store8(argument1 + count++, static_cast<uint8_t>(c));
+                if (c == '\n') break;
+            }
+            result = static_cast<int32_t>(count);
+            break;
+        }
+        case SYS_WRITE: {
+            if (argument0 != 1 && argument0 != 2) {
+                result = ERROR_BAD_FILE;
+                break;
+            }
+            // A page at a time, so the guest's length never sizes a host buffer
+            uint32_t count = std::min(argument2, MAX_TRANSFER);
+            std::ostream& out = argument0 == 1 ? *console : std::cerr;
+            uint8_t chunk[DataMemory::PAGE_SIZE];
+            for (uint32_t done = 0; done < count;) {
+                uint32_t size = std::min(count - done, DataMemory::PAGE_SIZE);
+                memory.readBytes(argument1 + done, chunk, size);
+                out.write(reinterpret_cast<const char*>(chunk), size);
+                done += size;
+            }
+            out.flush();
+            result = static_cast<int32_t>(count);
+            break;
+        }
+        case SYS_EXIT:
+        case SYS_EXIT_GROUP:
+            state.halt = ProgramHalt::Exit;
+            state.exitCode = static_cast<int32_t>(argument0);
+            return;
+        case SYS_CLOCK_GETTIME:
+            writeTime(memory, argument1, cycle, 1000000000);
+            break;
+        case SYS_GETTIMEOFDAY:
+            writeTime(memory, argument0, cycle, 1000000);
+            break;
+        case SYS_BRK:
+            if (argument0 > state.programBreak) state.programBreak = argument0;
+            result = static_cast<int32_t>(state.programBreak);
+            break;
+        default:
+            if (unsupported.insert(number).second) {
+                std::cerr << "Warning: Unsupported system call " << number << std::endl;
+            }
+            result = ERROR_NOT_SUPPORTED;
+    }
+    registers[A0] = result;
+}
@@ -0,0 +1,57 @@
+#ifndef SYSCALL_HPP
+#define SYSCALL_HPP
+
+#include "functional.hpp"
+#include "memory.hpp"
+#include "program.hpp"
+#include <cstdint>
+#include <iostream>
+#include <set>
+
+// RISC-V Linux system call numbers, as the proxy kernel and newlib use them.
+enum SyscallNumber : uint32_t {
+    SYS_READ = 63,
+    SYS_WRITE = 64,
+    SYS_EXIT = 93,
+    SYS_EXIT_GROUP = 94,
+    SYS_CLOCK_GETTIME = 113,
+    SYS_GETTIMEOFDAY = 169,
+    SYS_BRK = 214
+};
+
+// Proxy-kernel style emulation of the system calls a bare-metal program
+// needs to print, read, allocate, time itself and exit. a7 selects the
+// call, a0-a2 hold its arguments and a0 gets the result, negative errno
+// values for errors:
+//   - read(0, buf, n) reads up to n bytes of one line from standard input
+//   - write(1 or 2, buf, n) goes to the console or to standard error
+//   - both transfer at most 0x7ffff000 bytes per call, as Linux does, and
+//     return the count transferred
+//   - exit and exit_group stop the program with a0 as its exit code
+//   - brk(addr) moves the end of the heap up to addr and returns the end;
+//     brk(0) asks where it is. The heap starts on the page after the
+//     program image.
+//   - clock_gettime and gettimeofday fill a struct with a 64-bit seconds
+//     field and a 32-bit nanosecond or microsecond field. The simulated
+//     clock runs at 1 GHz from the start of the run.
+// Anything else returns -ENOSYS, with a warning on stderr the first time.
+class SystemCalls {
+public:
+    // Where writes to file descriptor 1 go; std::cout unless changed.
+    void setConsole(std::ostream& out) { console = &out; }
+
+    // Runs one ECALL on `state`. `registers` is where the call reads its
+    // arguments and leaves its result: state.registers or a copy of them.
+    // `cycle` is the current time in cycles.
+    void call(ArchState& state, int32_t* registers, DataMemory& memory, uint64_t cycle);
+
+private:
+    std::ostream* console = &std::cout;
+    std::set<uint32_t> unsupported;  // already warned about
+};
+
+// First address past the program image, rounded up to a page: where the
+// heap of `program` starts.
+uint32_t initialBreak(const Program& program);
+
+#endif
@@ -0,0 +1,200 @@
+#include "trace.hpp"
+#include <cstring>
+#include <stdexcept>
+
+static const char MAGIC[8] = {'R', 'V', 'S', 'I', 'M', 'T', 'R', 'C'};
+static const uint8_t VERSION = 1;
+// The kind byte keeps the record kind in its low three bits; STAGE puts
+// the stage above it and HELD_BIT on top.
+static const uint8_t HELD_BIT = 0x80;
+
+static uint8_t kindByte(TraceRecord kind) {
+    return static_cast<uint8_t>(kind);
+}
+
+TraceWriter::~TraceWriter() {
+    if (!file) return;
+    drain();
+    std::fflush(file);
+    if (ownsFile) std::fclose(file);
+}
+
+void TraceWriter::open(const std::string& path, const char* engine, const DiagramStyle& style, uint32_t base,
+                       const std::vector<std::string>& labels) {
+    if (path == "-") {
+        file = stdout;
+        ownsFile = false;
+    } else {
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) throw std::runtime_error("Could not open trace file: " + path);
+        ownsFile = true;
+    }
+    buffer.resize(BUFFER_SIZE);
+    used = 0;
+    cycle = 0;
+    started = false;
+
+    for (char c : MAGIC) byte(static_cast<uint8_t>(c));
+    byte(VERSION);
+    auto string = [this](const std::string& text) {
+        varint(text.size());
+        for (char c : text) byte(static_cast<uint8_t>(c));
+    };
+    string(engine);
+    byte(static_cast<uint8_t>(style.empty));
+    byte(static_cast<uint8_t>(style.stall));
+    byte(style.skipIdleRows);
+    byte(style.slots);
+    varint(base);
+    varint(labels.size());
+    for (const std::string& label : labels) string(label);
+}
+
+void TraceWriter::close(uint32_t cycles) {
+    if (!file) return;
+    byte(kindByte(TraceRecord::End));
+    varint(cycles);
+    drain();
+    std::fflush(file);
+    if (ownsFile) std::fclose(file);
+    file = nullptr;
+    ownsFile = false;
+}
+
+void TraceWriter::stage(uint32_t currentCycle, uint64_t instance, size_t row, Stage stage, bool held,
+                        uint8_t slot, uint8_t part) {
+    advance(currentCycle);
+    if (!started || instance > newest) {
+        byte(kindByte(TraceRecord::Start));
+        varint(started ? instance - newest - 1 : 0);
+        varint(row);
+        newest = instance;
+        started = true;
+    }
+    uint8_t kind = kindByte(TraceRecord::Stage) | static_cast<uint8_t>(static_cast<uint8_t>(stage) << 3);
+    event(held ? kind | HELD_BIT : kind, instance);
+    byte(static_cast<uint8_t>(part << 4 | slot));
+}
+
+void TraceWriter::retire(uint32_t currentCycle, uint64_t instance) {
+    advance(currentCycle);
+    event(kindByte(TraceRecord::Retire), instance);
+}
+
+void TraceWriter::flush(uint32_t currentCycle, uint64_t instance) {
+    if (!started || instance > newest) return;  // never traced
+    advance(currentCycle);
+    event(kindByte(TraceRecord::Flush), instance);
+}
+
+void TraceWriter::advance(uint32_t toCycle) {
+    if (toCycle == cycle) return;
+    byte(kindByte(TraceRecord::Cycle));
+    varint(toCycle - cycle);
+    cycle = toCycle;
+}
+
+void TraceWriter::event(uint8_t kind, uint64_t instance) {
+    byte(kind);
+    varint(newest - instance);
+}
+
+void TraceWriter::varint(uint64_t value) {
+    while (value >= 0x80) {
+        byte(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    byte(static_cast<uint8_t>(value));
+}
+
+void TraceWriter::drain() {
+    if (used == 0) return;
+    std::fwrite(buffer.data(), 1, used, file);
+    used = 0;
+}
+
+TraceReader::TraceReader(const std::string& path) : path(path) {
+    file = path == "-" ? stdin : std::fopen(path.c_str(), "rb");
+    if (!file) throw std::runtime_error("Could not open trace file: " + path);
+    buffer.resize(1 << 20);
+
+    char magic[sizeof(MAGIC)];
+    for (char& c : magic) c = static_cast<char>(byte());
+    if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a pipeline trace: " + path);
+    }
+    if (byte() != VERSION) throw std::runtime_error("Unsupported trace version: " + path);
+    engineName = string();
+    diagram.empty = static_cast<char>(byte());
+    diagram.stall = static_cast<char>(byte());
+    diagram.skipIdleRows = byte() != 0;
+    diagram.slots = byte() != 0;
+    baseAddress = static_cast<uint32_t>(varint());
+    rowLabels.resize(varint());
+    for (std::string& label : rowLabels) label = string();
+}
+
+TraceReader::~TraceReader() {
+    if (file && file != stdin) std::fclose(file);
+}
+
+bool TraceReader::next(TraceEvent& event) {
+    if (ended) return false;
+    uint8_t kind = byte();
+    event.kind = static_cast<TraceRecord>(kind & 0x7);
+    switch (event.kind) {
+        case TraceRecord::Stage: {
+            event.stage = static_cast<Stage>((kind >> 3) & 0xF);
+            event.held = (kind & HELD_BIT) != 0;
+            event.value = varint();
+            uint8_t position = byte();
+            event.part = position >> 4;
+            event.slot = position & 0xF;
+            if (event.stage < Stage::IF || event.stage > Stage::WB) {
+                throw std::runtime_error("Corrupt trace file: " + path);
+            }
+            break;
+        }
+        case TraceRecord::Start:
+            event.skipped = varint();
+            event.value = varint();
+            break;
+        case TraceRecord::Cycle:
+        case TraceRecord::Retire:
+        case TraceRecord::Flush:
+            event.value = varint();
+            break;
+        case TraceRecord::End:
+            event.value = varint();
+            ended = true;
+            break;
+        default:
+            throw std::runtime_error("Corrupt trace file: " + path);
+    }
+    return true;
+}
+
+uint8_t TraceReader::byte() {
+    if (used == available) {
+        available = std::fread(buffer.data(), 1, buffer.size(), file);
+        used = 0;
+        if (available == 0) throw std::runtime_error("Truncated trace file: " + path);
+    }
+    return buffer[used++];
+}
+
+uint64_t TraceReader::varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t next = byte();
+        value |= static_cast<uint64_t>(next & 0x7F) << shift;
+        if (!(next & 0x80)) return value;
+    }
+    throw std::runtime_error("Corrupt trace file: " + path);
+}
+
+std::string TraceReader::string() {
+    std::string text(varint(), '\0');
+    for (char& c : text) c = static_cast<char>(byte());
+    return text;
+}
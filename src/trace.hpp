@@ -0,0 +1,133 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include "history.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Binary pipeline trace written while the simulation runs, for runs too
+// long for the diagram. The file starts with
+//
+//     "RVSIMTRC" version engine-name diagram-style base row-labels
+//
+// and continues with records: a kind byte, then LEB128 varints.
+//
+//     CYCLE  delta    later records are `delta` cycles after earlier ones;
+//                     cycles count diagram columns from 0
+//     START  skipped row
+//                     a new instruction instance enters IF; instances are
+//                     numbered from 0 in START order, leaving `skipped`
+//                     numbers unused before this one
+//     STAGE  age      instance newest - `age` occupies a stage; the kind
+//                     byte holds the stage and whether the diagram draws
+//                     it as held, and one more byte holds the sub-stage
+//                     (high nibble) and slot (low nibble)
+//     RETIRE age      it leaves WB at the end of the cycle
+//     FLUSH  age      it is dropped
+//     END    cycles   the length of the run; the last record
+//
+// Only what changes is written, so a scalar run costs about three bytes
+// per instruction and stage. Output goes through a large private buffer;
+// the path "-" selects stdout. traceconv turns a trace back into the
+// diagram or into a Kanata log for pipeline viewers.
+class TraceWriter {
+public:
+    TraceWriter() = default;
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+    ~TraceWriter();
+
+    // `labels` holds one diagram label per program row; throws
+    // std::runtime_error.
+    void open(const std::string& path, const char* engine, const DiagramStyle& style, uint32_t base,
+              const std::vector<std::string>& labels);
+    bool isOpen() const { return file != nullptr; }
+    // Writes the END record with the run's length and closes the file.
+    void close(uint32_t cycles);
+
+    // Events of `instance`, the simulator's fetch sequence number. An
+    // instance's first event starts it, so instances must first appear in
+    // the order they were numbered; `cycle` never decreases.
+    void stage(uint32_t cycle, uint64_t instance, size_t row, Stage stage, bool held, uint8_t slot = 0,
+               uint8_t part = 0);
+    void retire(uint32_t cycle, uint64_t instance);
+    void flush(uint32_t cycle, uint64_t instance);
+
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 20;
+
+    FILE* file = nullptr;
+    bool ownsFile = false;
+    std::vector<uint8_t> buffer;
+    size_t used = 0;
+
+    uint32_t cycle = 0;
+    uint64_t newest = 0;  // last instance started, if `started`
+    bool started = false;
+
+    void advance(uint32_t toCycle);
+    void event(uint8_t kind, uint64_t instance);
+    void byte(uint8_t value) {
+        if (used == buffer.size()) drain();
+        buffer[used++] = value;
+    }
+    void varint(uint64_t value);
+    void drain();
+};
+
+enum class TraceRecord : uint8_t {
+    Cycle = 0,
+    Start,
+    Stage,
+    Retire,
+    Flush,
+    End
+};
+
+struct TraceEvent {
+    TraceRecord kind = TraceRecord::End;
+    uint64_t value = 0;      // delta, row, age or cycles, by kind
+    uint64_t skipped = 0;    // START only
+    Stage stage = Stage::Empty;
+    bool held = false;
+    uint8_t slot = 0;
+    uint8_t part = 0;
+};
+
+// Reads a trace back; throws std::runtime_error on a bad or truncated file.
+class TraceReader {
+public:
+    explicit TraceReader(const std::string& path);
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+    ~TraceReader();
+
+    const std::string& engine() const { return engineName; }
+    const DiagramStyle& style() const { return diagram; }
+    uint32_t base() const { return baseAddress; }
+    const std::vector<std::string>& labels() const { return rowLabels; }
+
+    // The next record; false after END.
+    bool next(TraceEvent& event);
+
+private:
+    FILE* file = nullptr;
+    std::string path;
+    std::vector<uint8_t> buffer;
+    size_t used = 0;
+    size_t available = 0;
+    bool ended = false;
+
+    std::string engineName;
+    DiagramStyle diagram{' ', '-', false, false};
+    uint32_t baseAddress = 0;
+    std::vector<std::string> rowLabels;
+
+    uint8_t byte();
+    uint64_t varint();
+    std::string string();
+};
+
+#endif
@@ -0,0 +1,200 @@
+#include "trace.hpp"
+#include "history.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Converts a pipeline trace written with --trace:
+//
+//     traceconv <tracefile> [--format text|kanata]
+//
+// text (the default) prints the diagram the simulator would have printed
+// for the same run; kanata prints a Kanata 0004 log for pipeline viewers
+// such as Konata, one instruction per dynamic instance. Output goes to
+// stdout; the trace file "-" is read from stdin.
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <tracefile> [--format text|kanata]" << std::endl;
+}
+
+// Live instances by the id START gave them; an instance is forgotten once
+// it retires or is flushed.
+class Instances {
+public:
+    uint64_t start(uint64_t skipped, size_t row) {
+        count += skipped;
+        live[count] = row;
+        return count++;
+    }
+    // The instance numbered `age` before the newest.
+    uint64_t id(uint64_t age) const {
+        if (count == 0 || age >= count) throw std::runtime_error("Corrupt trace file: no such instruction");
+        return count - 1 - age;
+    }
+    size_t row(uint64_t id) const {
+        auto found = live.find(id);
+        if (found == live.end()) throw std::runtime_error("Corrupt trace file: instruction already gone");
+        return found->second;
+    }
+    void end(uint64_t id) { live.erase(id); }
+
+private:
+    std::unordered_map<uint64_t, size_t> live;
+    uint64_t count = 0;
+};
+
+static void writeText(TraceReader& reader, std::ostream& out) {
+    const std::vector<std::string>& labels = reader.labels();
+    PipelineHistory history;
+    history.reset(labels.size());
+    Instances instances;
+    uint32_t cycle = 0;
+    TraceEvent event;
+    while (reader.next(event)) {
+        switch (event.kind) {
+            case TraceRecord::Cycle:
+                cycle += static_cast<uint32_t>(event.value);
+                break;
+            case TraceRecord::Start:
+                instances.start(event.skipped, static_cast<size_t>(event.value));
+                break;
+            case TraceRecord::Stage: {
+                size_t row = instances.row(instances.id(event.value));
+                history.record(row, cycle, event.held ? Stage::Stall : event.stage, event.slot, event.part);
+                break;
+            }
+            case TraceRecord::Retire:
+            case TraceRecord::Flush:
+                instances.end(instances.id(event.value));
+                break;
+            case TraceRecord::End:
+                history.write(out, labels, static_cast<uint32_t>(event.value), reader.style());
+                break;
+        }
+    }
+}
+
+// Kanata shows an instruction in a stage until its next S or R command, so
+// a retirement is written one cycle after the instruction's WB. Kanata ids
+// count instructions in the order they start; the trace's instance number
+// is kept as the simulator id.
+static void writeKanata(TraceReader& reader, std::ostream& out) {
+    struct Shown {
+        uint64_t id;        // in the Kanata log
+        std::string stage;  // drawn in
+    };
+    const std::vector<std::string>& labels = reader.labels();
+    Instances instances;
+    std::unordered_map<uint64_t, Shown> shown;
+    std::vector<uint64_t> retiring;
+    uint64_t started = 0;
+    uint64_t retired = 0;
+
+    // Ends the instance numbered `age` before the newest; `flushed` or
+    // retired.
+    auto end = [&](uint64_t age, bool flushed) {
+        uint64_t instance = instances.id(age);
+        instances.end(instance);
+        auto found = shown.find(instance);
+        if (found == shown.end()) throw std::runtime_error("Corrupt trace file: instruction already gone");
+        uint64_t id = found->second.id;
+        shown.erase(found);
+        if (!flushed) {
+            retiring.push_back(id);
+            return;
+        }
+        out << "R\t" << id << '\t' << retired++ << "\t1\n";
+    };
+    auto retirePending = [&]() {
+        for (uint64_t id : retiring) out << "R\t" << id << '\t' << retired++ << "\t0\n";
+        retiring.clear();
+    };
+
+    out << "Kanata\t0004\nC=\t0\n";
+    TraceEvent event;
+    while (reader.next(event)) {
+        switch (event.kind) {
+            case TraceRecord::Cycle:
+                if (retiring.empty()) {
+                    out << "C\t" << event.value << '\n';
+                    break;
+                }
+                out << "C\t1\n";
+                retirePending();
+                if (event.value > 1) out << "C\t" << event.value - 1 << '\n';
+                break;
+            case TraceRecord::Start: {
+                size_t row = static_cast<size_t>(event.value);
+                uint64_t instance = instances.start(event.skipped, row);
+                uint64_t id = started++;
+                shown[instance] = {id, ""};
+                char address[16];
+                std::snprintf(address, sizeof(address), "%08x", static_cast<unsigned>(reader.base() + 4 * row));
+                out << "I\t" << id << '\t' << instance << "\t0\n";
+                out << "L\t" << id << "\t0\t" << address << ": " << (row < labels.size() ? labels[row] : "") << '\n';
+                break;
+            }
+            case TraceRecord::Stage: {
+                auto found = shown.find(instances.id(event.value));
+                if (found == shown.end()) throw std::runtime_error("Corrupt trace file: instruction already gone");
+                std::string name = stageName(event.stage);
+                if (event.part) name += static_cast<char>('0' + event.part);
+                if (found->second.stage != name) {
+                    out << "S\t" << found->second.id << "\t0\t" << name << '\n';
+                    found->second.stage = name;
+                }
+                break;
+            }
+            case TraceRecord::Retire:
+            case TraceRecord::Flush:
+                end(event.value, event.kind == TraceRecord::Flush);
+                break;
+            case TraceRecord::End:
+                if (!retiring.empty()) {
+                    out << "C\t1\n";
+                    retirePending();
+                }
+                break;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string path;
+    std::string format = "text";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            format = argv[++i];
+            if (format != "text" && format != "kanata") {
+                std::cerr << "Error: --format needs text or kanata." << std::endl;
+                return 1;
+            }
+        } else if (path.empty() && (arg == "-" || arg.rfind("--", 0) != 0)) {
+            path = arg;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (path.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        std::ios::sync_with_stdio(false);
+        TraceReader reader(path);
+        if (format == "kanata") writeKanata(reader, std::cout);
+        else writeText(reader, std::cout);
+        std::cout.flush();
+    } catch (const std::exception& e) {
+        std::cerr << "Runtime Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
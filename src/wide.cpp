@@ -0,0 +1,452 @@
+#include "wide.hpp"
+#include "driver.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+static const int DEFAULT_WIDTH = 2;
+static const int DEFAULT_MEMORY_PORTS = 1;
+static constexpr DiagramStyle WIDE_DIAGRAM{' ', '-', false, true};
+static const char* const ENGINE_NAME = "superscalar";
+
+static bool inFlight(const std::vector<PipelineStage>& latch) {
+    return std::any_of(latch.begin(), latch.end(), [](const PipelineStage& stage) { return stage.hasData; });
+}
+
+WideProcessor::WideProcessor(int width, int memoryPorts, const DepthConfig& depth)
+    : width(width), memoryPorts(memoryPorts), depth(depth), fetchLatches(depth.fetchStages - 1, Group(width)),
+      fetchToDecode(width), decodeToExecute(width),
+      executeToWriteback(depth.executeStages + depth.memoryStages, Group(width)), output(&std::cout) {}
+
+void WideProcessor::loadProgramFromFile(const std::string& filename) {
+    program = loadProgram(filename);
+    for (const MemorySegment& segment : program.segments) {
+        state.memory.writeBytes(segment.address, segment.bytes, segment.fileSize);
+    }
+    state.pc = program.entry;
+    state.programBreak = initialBreak(program);
+    pipelineHistory.reset(program.size(), program.base, diagramWindow);
+}
+
+uint64_t WideProcessor::fastForward(uint64_t maxInstructions, uint32_t untilPc) {
+    return runFunctional(program, state, systemCalls, maxInstructions, untilPc);
+}
+
+void WideProcessor::setPredictor(const PredictorConfig& config) {
+    if (config.kind != PredictorKind::None) {
+        throw std::invalid_argument("The superscalar engine does not model branch prediction");
+    }
+}
+
+void WideProcessor::setCaches(const CacheConfig& instruction, const CacheConfig& data) {
+    if (instruction.enabled || data.enabled) {
+        throw std::invalid_argument("The superscalar engine does not model caches");
+    }
+}
+
+void WideProcessor::setProfile(bool enabled) {
+    if (enabled) throw std::invalid_argument("The superscalar engine does not profile cycles per instruction");
+}
+
+void WideProcessor::writeProfile(std::ostream&, bool) const {
+    throw std::runtime_error("The superscalar engine does not profile cycles per instruction");
+}
+
+void WideProcessor::saveCheckpoint(const std::string&) const {
+    throw std::runtime_error("Checkpoints are not supported by the superscalar engine");
+}
+
+void WideProcessor::loadCheckpoint(const std::string&) {
+    throw std::runtime_error("Checkpoints are not supported by the superscalar engine");
+}
+
+void WideProcessor::runSimulation(int totalCycles) {
+    maxCycleLimit = totalCycles;
+    if (program.empty()) {
+        *output << "No program loaded. Stopping." << std::endl;
+        maxCycleLimit = 0;
+        return;
+    }
+    if (state.halt != ProgramHalt::None) {
+        *output << "Program has already stopped. Stopping." << std::endl;
+        maxCycleLimit = 0;
+        return;
+    }
+
+    firstCycle = currentCycleCount;
+    counters.reset(program.size(), false, false, width);
+    for (; currentCycleCount - firstCycle < maxCycleLimit; ++currentCycleCount) {
+        if (cycleStream.isOpen()) cycleStream.beginCycle(currentCycleCount + 1);
+        writeBackToRegisters();
+        accessMemory();
+        executeInstructions();
+        decodeInstructions();
+        fetchInstructions();
+        if (cycleStream.isOpen()) cycleStream.endCycle();
+
+        // An exit or EBREAK stops the run once it has left the pipeline
+        if (state.halt != ProgramHalt::None && !inFlight()) {
+            if (state.halt == ProgramHalt::Exit) {
+                *output << "Program exited with code " << state.exitCode;
+            } else {
+                *output << "EBREAK at 0x" << std::hex << haltAddress << std::dec;
+            }
+            *output << ". Stopping at cycle " << currentCycleCount + 1 << "." << std::endl;
+            maxCycleLimit = currentCycleCount + 1 - firstCycle;
+            break;
+        }
+    }
+    counters.cycles = static_cast<uint64_t>(maxCycleLimit);
+    cycleStream.close();
+    trace.close(static_cast<uint32_t>(maxCycleLimit));
+}
+
+void WideProcessor::displayPipeline() {
+    pipelineHistory.write(*output, program.labels(), maxCycleLimit, WIDE_DIAGRAM);
+}
+
+void WideProcessor::writeCounters(std::ostream& out) const {
+    counters.writeJson(out, ENGINE_NAME, predictorName(PredictorKind::None), program.labels(), program.base);
+}
+
+void WideProcessor::streamTo(const std::string& path) {
+    cycleStream.open(path, width, depth);
+}
+
+void WideProcessor::traceTo(const std::string& path) {
+    trace.open(path, ENGINE_NAME, WIDE_DIAGRAM, program.base, program.labels());
+}
+
+// Whether any instruction is still in the pipeline.
+bool WideProcessor::inFlight() const {
+    auto any = [](const std::vector<Group>& latches) {
+        return std::any_of(latches.begin(), latches.end(), [](const Group& group) { return ::inFlight(group); });
+    };
+    return any(fetchLatches) || ::inFlight(fetchToDecode) || ::inFlight(decodeToExecute) ||
+           any(executeToWriteback);
+}
+
+// Drops the groups in the fetch sub-stages ahead of ID.
+void WideProcessor::flushFetched() {
+    for (Group& group : fetchLatches) {
+        for (PipelineStage& stage : group) {
+            if (!stage.hasData) continue;
+            traceFlush(stage);
+            stage = PipelineStage();
+        }
+    }
+}
+
+// Counts and marks `stage` as flushed.
+void WideProcessor::traceFlush(const PipelineStage& stage) {
+    cycleStream.markFlush();
+    counters.flush(program.index(stage.programCounter));
+    if (trace.isOpen()) trace.flush(currentCycleCount - firstCycle, stage.sequence);
+}
+
+// Sequence numbers of the group of `count` IF is fetching at `address`,
+// from slot 0: the same as last cycle while IF waits to pass it on, else
+// new ones. A group IF gave up on (after a redirect) is flushed from the
+// trace.
+uint64_t WideProcessor::fetchInstances(uint32_t address, int count) {
+    if (fetchSequence && fetchSequenceAddress == address && fetchSequenceCount == count) return fetchSequence;
+    if (fetchSequence && trace.isOpen()) {
+        for (int slot = 0; slot < fetchSequenceCount; ++slot) {
+            trace.flush(currentCycleCount - firstCycle, fetchSequence + slot);
+        }
+    }
+    fetchSequence = nextSequence;
+    fetchSequenceAddress = address;
+    fetchSequenceCount = count;
+    nextSequence += count;
+    return fetchSequence;
+}
+
+void WideProcessor::logStage(uint32_t address, uint64_t sequence, Stage stage, int slot, int index, bool held) {
+    if (cycleStream.isOpen()) {
+        cycleStream.occupy(stage, address, slot, index);
+        if (held) cycleStream.markStall();
+        return;
+    }
+    if (!keepHistory && !trace.isOpen()) return;
+
+    Stage drawn = stage;
+    if (stage != Stage::WB) {
+        LoggedStage& last = lastLogged[depth.column(stage, index)][slot];
+        if (last.address == address && last.cycle == currentCycleCount - 1) drawn = Stage::Stall;
+        last.address = address;
+        last.cycle = currentCycleCount;
+    }
+    if (trace.isOpen()) {
+        trace.stage(currentCycleCount - firstCycle, sequence, program.index(address), stage, drawn == Stage::Stall,
+                    static_cast<uint8_t>(slot), depth.label(stage, index));
+        return;
+    }
+    pipelineHistory.record(program.index(address), currentCycleCount - firstCycle, drawn,
+                           static_cast<uint8_t>(slot), depth.label(stage, index));
+}
+
+void WideProcessor::fetchInstructions() {
+    // Nothing is fetched behind an exit or EBREAK
+    if (state.halt != ProgramHalt::None) return;
+    if (redirectCycle == currentCycleCount) {
+        state.pc = redirectTarget;
+    }
+    // Groups in the later fetch sub-stages move up once the one ahead has
+    // emptied; fetchLatches[k] is in IF(k+2) this cycle
+    for (int index = static_cast<int>(fetchLatches.size()) - 1; index >= 0; --index) {
+        Group& group = fetchLatches[index];
+        Group& next = index + 1 < static_cast<int>(fetchLatches.size()) ? fetchLatches[index + 1] : fetchToDecode;
+        bool held = ::inFlight(next);
+        for (int slot = 0; slot < width; ++slot) {
+            const PipelineStage& stage = group[slot];
+            if (stage.hasData) logStage(stage.programCounter, stage.sequence, Stage::IF, slot, index + 1, held);
+        }
+        if (!held) std::swap(group, next);
+    }
+
+    // A new group is only fetched once the sub-stage after IF1 has emptied
+    Group& first = fetchLatches.empty() ? fetchToDecode : fetchLatches[0];
+    bool busy = ::inFlight(first);
+
+    int count = 0;
+    while (count < width && program.contains(state.pc + 4 * count)) ++count;
+    uint64_t sequence = fetchInstances(state.pc, count);
+    uint32_t address = state.pc;
+    for (int slot = 0; slot < count; ++slot, address += 4) {
+        if (busy) {
+            logStage(address, sequence + slot, Stage::IF, slot, 0, true);
+            continue;
+        }
+        PipelineStage& fetched = first[slot];
+        fetched.instruction = &program.instructions[program.index(address)];
+        fetched.programCounter = address;
+        fetched.hasData = true;
+        fetched.sequence = sequence + slot;
+        logStage(address, fetched.sequence, Stage::IF, slot, 0);
+    }
+    if (!busy) {
+        state.pc = address;
+        fetchSequence = 0;
+    }
+}
+
+void WideProcessor::decodeInstructions() {
+    // The group fetched behind a taken branch or jump is dropped
+    if (redirectCycle == currentCycleCount) {
+        for (PipelineStage& stage : fetchToDecode) {
+            if (!stage.hasData) continue;
+            traceFlush(stage);
+            stage = PipelineStage();
+        }
+        flushFetched();
+    }
+
+    std::fill(decodeToExecute.begin(), decodeToExecute.end(), PipelineStage());
+    int issued = 0;
+    int memoryOps = 0;
+    bool blocked = false;
+    bool serialized = false;  // an ECALL issued: the rest of the group waits a cycle
+    for (int slot = 0; slot < width; ++slot) {
+        PipelineStage& stage = fetchToDecode[slot];
+        if (!stage.hasData) continue;
+        // Issue is in order: everything behind the first held instruction waits too
+        if (!blocked) {
+            StallCause cause = serialized ? StallCause::Serialize
+                                          : issueHazard(*stage.instruction, issued, memoryOps);
+            if (cause != StallCause::None) {
+                counters.stall(cause, program.index(stage.programCounter));
+                blocked = true;
+            }
+        }
+        if (blocked) {
+            logStage(stage.programCounter, stage.sequence, Stage::ID, slot, 0, true);
+            continue;
+        }
+
+        const DecodedInstruction& current = *stage.instruction;
+        if (current.has(DEC_MEM_READ) || current.has(DEC_MEM_WRITE)) ++memoryOps;
+        logStage(stage.programCounter, stage.sequence, Stage::ID, slot, 0);
+        bool redirected = issue(stage);
+        serialized = current.system != SYSTEM_NONE;
+        ++counters.slotIssued[issued];
+        decodeToExecute[issued++] = stage;
+        stage = PipelineStage();
+        if (redirected || state.halt != ProgramHalt::None) {
+            for (int younger = slot + 1; younger < width; ++younger) {
+                if (!fetchToDecode[younger].hasData) continue;
+                traceFlush(fetchToDecode[younger]);
+                fetchToDecode[younger] = PipelineStage();
+            }
+            if (state.halt != ProgramHalt::None) flushFetched();
+            break;
+        }
+    }
+    ++counters.issueGroups[issued];
+}
+
+// Why `current` cannot issue this cycle behind `issued` instructions, of
+// which `memoryOps` loads and stores, if anything stops it. Operands are
+// needed in EX1 in the next cycle, in ID right now for branches and jalr,
+// and in the `store` MEM sub-stage for store data.
+StallCause WideProcessor::issueHazard(const DecodedInstruction& current, int issued, int memoryOps) const {
+    int cycle = currentCycleCount;
+    if (current.system != SYSTEM_NONE) {
+        bool older = issued > 0 || std::any_of(executeToWriteback.begin(), executeToWriteback.end(),
+                                               [](const Group& group) { return ::inFlight(group); });
+        return older ? StallCause::Serialize : StallCause::None;
+    }
+    bool readInDecode = current.branchKind == BRANCH_CONDITIONAL || current.branchKind == BRANCH_JALR;
+    uint32_t readInMemory = 0;
+    if (current.has(DEC_MEM_WRITE)) {
+        readInMemory = (1u << current.srcReg2) & ~(current.has(DEC_USES_RS1) ? 1u << current.srcReg1 : 0);
+    }
+    for (uint32_t sources = current.srcMask; sources; sources &= sources - 1) {
+        int reg = __builtin_ctz(sources);
+        int needed = readInDecode                 ? cycle
+                     : (readInMemory >> reg) & 1 ? cycle + depth.executeStages + depth.storeLatency
+                                                 : cycle + 1;
+        if (readInDecode && readyCause[reg] == StallCause::MulDivResult) {
+            // As in the forward engine, ID gets the unit's results a cycle after EX
+            if (readyCycle[reg] > cycle - 1) return StallCause::MulDivResult;
+        } else if (readyCycle[reg] > needed) {
+            if (readInDecode) return StallCause::BranchOperand;
+            // A producer from an earlier group is still in a multi-cycle EX
+            bool earlier = readyCycle[reg] < cycle + depth.aluLatency + 1;
+            if (readyCause[reg] == StallCause::GroupDependency && earlier) return StallCause::ExecuteLatency;
+            return readyCause[reg];
+        }
+    }
+    if ((current.has(DEC_MEM_READ) || current.has(DEC_MEM_WRITE)) && memoryOps == memoryPorts) {
+        return StallCause::MemoryPorts;
+    }
+    if (current.has(DEC_MULDIV) && muldiv.acceptCycle(current.aluOp) > cycle + 1) {
+        return StallCause::MulDivBusy;
+    }
+    return StallCause::None;
+}
+
+// Executes the instruction in `stage` on the architectural state and
+// records when its result can be bypassed. Returns true when it is a
+// taken branch or a jump, which redirects fetch in the next cycle.
+bool WideProcessor::issue(const PipelineStage& stage) {
+    const DecodedInstruction& current = *stage.instruction;
+    uint32_t address = stage.programCounter;
+    int32_t* registers = state.registers;
+    int32_t operand1 = current.has(DEC_USES_RS1) ? registers[current.srcReg1] : 0;
+    int32_t operand2 = current.has(DEC_ALU_IMM) ? current.immediate : registers[current.srcReg2];
+
+    int32_t result = static_cast<int32_t>(address + 4);  // the link value of jumps
+    int ready = currentCycleCount + depth.aluLatency + 1;
+    StallCause cause = StallCause::GroupDependency;
+    bool taken = false;
+    uint32_t target = 0;
+    if (current.system == SYSTEM_EBREAK) {
+        state.halt = ProgramHalt::Breakpoint;
+        haltAddress = address;
+        return false;
+    }
+    if (current.system == SYSTEM_ECALL) {
+        systemCalls.call(state, registers, state.memory, static_cast<uint64_t>(currentCycleCount));
+        haltAddress = address;
+        return false;
+    }
+    switch (current.branchKind) {
+        case BRANCH_NONE:
+            if (current.has(DEC_BUBBLE)) return false;
+            result = aluCompute(current.aluOp, operand1, operand2);
+            if (current.has(DEC_MEM_READ)) {
+                result = state.memory.load(result, current.memOp);
+                ready = currentCycleCount + depth.executeStages + depth.loadStage() + 1;
+                cause = StallCause::LoadUse;
+            } else if (current.has(DEC_MEM_WRITE)) {
+                state.memory.store(result, current.memOp, registers[current.srcReg2]);
+            } else if (current.has(DEC_MULDIV)) {
+                int execute = currentCycleCount + 1;
+                ready = execute + static_cast<int>(muldiv.issue(current.aluOp, operand1, execute));
+                cause = StallCause::MulDivResult;
+            }
+            break;
+        case BRANCH_CONDITIONAL:
+            taken = branchTaken(current.branchOp, operand1, operand2);
+            target = address + current.immediate;
+            break;
+        case BRANCH_JAL:
+            taken = true;
+            target = address + current.immediate;
+            break;
+        case BRANCH_JALR:
+            taken = true;
+            target = (static_cast<uint32_t>(operand1) + current.immediate) & ~1U;
+            break;
+    }
+    if (current.destMask) {
+        registers[current.destReg] = result;
+        readyCycle[current.destReg] = ready;
+        readyCause[current.destReg] = cause;
+    }
+    if (current.branchKind == BRANCH_NONE) return false;
+
+    // Fetch always continues at PC + 4, so only a fall-through was foreseen
+    counters.resolve(current.branchKind == BRANCH_CONDITIONAL, !taken);
+    if (taken) {
+        redirectTarget = target;
+        redirectCycle = currentCycleCount + 1;
+    }
+    return taken;
+}
+
+void WideProcessor::executeInstructions() {
+    for (int index = depth.executeStages - 1; index >= 0; --index) {
+        Group& group = executeToWriteback[index];
+        group = index ? executeToWriteback[index - 1] : decodeToExecute;
+        for (int slot = 0; slot < width; ++slot) {
+            const PipelineStage& stage = group[slot];
+            if (stage.hasData) logStage(stage.programCounter, stage.sequence, Stage::EX, slot, index);
+        }
+    }
+}
+
+void WideProcessor::accessMemory() {
+    for (int index = depth.memoryStages - 1; index >= 0; --index) {
+        Group& group = executeToWriteback[depth.executeStages + index];
+        group = executeToWriteback[depth.executeStages + index - 1];
+        for (int slot = 0; slot < width; ++slot) {
+            const PipelineStage& stage = group[slot];
+            if (stage.hasData) logStage(stage.programCounter, stage.sequence, Stage::MEM, slot, index);
+        }
+    }
+}
+
+void WideProcessor::writeBackToRegisters() {
+    for (int slot = 0; slot < width; ++slot) {
+        const PipelineStage& stage = executeToWriteback.back()[slot];
+        if (!stage.hasData) continue;
+        counters.retire(program.index(stage.programCounter));
+        logStage(stage.programCounter, stage.sequence, Stage::WB, slot, 0);
+        if (trace.isOpen()) trace.retire(currentCycleCount - firstCycle, stage.sequence);
+    }
+}
+
+int runSuperscalar(int argc, char* argv[]) {
+    SimOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    if (const char* option = foreignOption(options, ENGINE_NAME)) {
+        std::cerr << "Error: " << option << " is not supported by " << ENGINE_NAME << "." << std::endl;
+        return 1;
+    }
+    int width = options.issueWidth ? options.issueWidth : DEFAULT_WIDTH;
+    int memoryPorts = options.memoryPorts ? options.memoryPorts : DEFAULT_MEMORY_PORTS;
+    if (memoryPorts > width) {
+        std::cerr << "Error: --mem-ports cannot exceed the issue width (" << width << ")." << std::endl;
+        return 1;
+    }
+    if (!options.loadCheckpoint.empty() || !options.saveCheckpoint.empty()) {
+        std::cerr << "Error: Checkpoints are not supported by the superscalar engine." << std::endl;
+        return 1;
+    }
+
+    WideProcessor simulator(width, memoryPorts, options.depth);
+    return runWithOptions(simulator, options);
+}
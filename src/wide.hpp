@@ -0,0 +1,142 @@
+#ifndef WIDE_HPP
+#define WIDE_HPP
+
+#include "structures.hpp"
+#include "program.hpp"
+#include "functional.hpp"
+#include "history.hpp"
+#include "stream.hpp"
+#include "trace.hpp"
+#include "counters.hpp"
+#include "predictor.hpp"
+#include "cache.hpp"
+#include "muldiv.hpp"
+#include "syscall.hpp"
+#include "depth.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// In-order superscalar version of the forwarding pipeline. Every stage
+// holds up to `width` instructions, one per slot:
+//   - IF fetches `width` sequential instructions once ID has emptied.
+//   - ID issues the longest in-order prefix of its group whose operands
+//     can be bypassed in time, with at most `memoryPorts` loads and stores
+//     and the multiply/divide unit free; the rest wait for later cycles.
+//   - EX, MEM and WB move a whole group per cycle; ALUs are duplicated, so
+//     only the RV32M unit is shared.
+// Results are bypassed between slots as well as between groups, so an
+// instruction may issue together with the producer of a store's data but
+// not with the producer of an operand EX needs. Branches and jumps are
+// resolved in ID as in the forward engine; a taken one drops the younger
+// instructions of its group and redirects fetch in the next cycle.
+// IF, EX and MEM can each be split into sub-stages (see DepthConfig). A
+// group moves to the next fetch sub-stage once that one has emptied, and
+// every group after ID moves on each cycle; results are bypassed from the
+// end of the sub-stage that produces them.
+// Instructions take effect on the architectural state when they issue, in
+// program order; the stages after ID only model timing. ECALL and EBREAK
+// issue alone, once the instructions ahead of them have written back.
+class WideProcessor {
+public:
+    WideProcessor(int width, int memoryPorts, const DepthConfig& depth = DepthConfig());
+    void loadProgramFromFile(const std::string& filename);
+    uint64_t fastForward(uint64_t maxInstructions, uint32_t untilPc = NO_STOP_PC);
+    uint32_t currentPc() const { return state.pc; }
+    // Branch prediction, caches and checkpoints are not modelled; asking
+    // for them throws std::invalid_argument or std::runtime_error.
+    void setPredictor(const PredictorConfig& config);
+    void setCaches(const CacheConfig& instruction, const CacheConfig& data);
+    void setMulDiv(const MulDivConfig& config) { muldiv.configure(config); }
+    void runSimulation(int totalCycles);
+    void displayPipeline();
+    void setOutput(std::ostream& out) {
+        output = &out;
+        systemCalls.setConsole(out);
+    }
+    int simulatedCycles() const { return maxCycleLimit; }
+    uint64_t retiredInstructions() const { return counters.retired; }
+    const PerfCounters& perfCounters() const { return counters; }
+    void writeCounters(std::ostream& out) const;
+    // Cycles are not attributed per instruction; asking for it throws
+    // std::invalid_argument or std::runtime_error.
+    void setProfile(bool enabled);
+    void writeProfile(std::ostream& out, bool folded) const;
+    void discardHistory() { keepHistory = false; }
+    void setWindow(const DiagramWindow& window) { diagramWindow = window; }
+    void streamTo(const std::string& path);
+    void traceTo(const std::string& path);
+    void saveCheckpoint(const std::string& path) const;
+    void loadCheckpoint(const std::string& path);
+
+private:
+    using Group = std::vector<PipelineStage>;
+
+    const int width;
+    const int memoryPorts;
+    const DepthConfig depth;
+    ArchState state;
+    Program program;
+
+    // One entry per slot; the ID group keeps the slots it was fetched into
+    std::vector<Group> fetchLatches;  // after IF1..IF(n-1)
+    Group fetchToDecode;
+    Group decodeToExecute;
+    std::vector<Group> executeToWriteback;  // after each EX and MEM sub-stage
+
+    PipelineHistory pipelineHistory;
+    DiagramWindow diagramWindow;
+    std::ostream* output;
+    CycleStream cycleStream;
+    TraceWriter trace;
+    MulDivUnit muldiv;
+    SystemCalls systemCalls;
+    uint32_t haltAddress = 0;
+    bool keepHistory = true;
+    int currentCycleCount = 0;
+    int firstCycle = 0;
+    int maxCycleLimit = 0;
+    PerfCounters counters;
+
+    int redirectCycle = -1;
+    uint32_t redirectTarget = 0;
+
+    uint64_t nextSequence = 1;       // for PipelineStage::sequence
+    uint64_t fetchSequence = 0;      // of slot 0 of the group IF is still fetching, 0 once latched
+    uint32_t fetchSequenceAddress = 0;
+    int fetchSequenceCount = 0;
+
+    // First cycle in which an instruction in EX can have each register
+    // bypassed to it, and what an instruction waiting for it is stalled on.
+    int readyCycle[32] = {};
+    StallCause readyCause[32] = {};
+
+    // Last instruction drawn in each slot of every sub-stage before WB; as
+    // in the forward engine a held instruction shows the stage name once
+    // and "-" afterwards
+    struct LoggedStage {
+        uint32_t address = 0;
+        int cycle = -2;
+    };
+    LoggedStage lastLogged[3 * MAX_SUBSTAGES + 1][MAX_ISSUE_WIDTH];
+
+    void fetchInstructions();
+    void decodeInstructions();
+    void executeInstructions();
+    void accessMemory();
+    void writeBackToRegisters();
+
+    void logStage(uint32_t address, uint64_t sequence, Stage stage, int slot, int index, bool held = false);
+    uint64_t fetchInstances(uint32_t address, int count);
+    void traceFlush(const PipelineStage& stage);
+    bool inFlight() const;
+    void flushFetched();
+    StallCause issueHazard(const DecodedInstruction& current, int issued, int memoryOps) const;
+    bool issue(const PipelineStage& stage);
+};
+
+// Parses the command line and runs the superscalar pipeline; the body of
+// the superscalar binary's main().
+int runSuperscalar(int argc, char* argv[]);
+
+#endif
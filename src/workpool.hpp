@@ -0,0 +1,74 @@
+#ifndef WORKPOOL_HPP
+#define WORKPOOL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs a fixed set of independent tasks on a group of threads. Each worker
+// owns a deque of task indices, takes work from its back, and once it runs
+// dry steals from the front of another worker's deque, so a few long
+// simulations do not leave the other cores idle. All tasks are known up
+// front, so a worker exits as soon as every deque is empty.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned threads)
+        : threadCount(threads == 0 ? 1 : threads) {}
+
+    // Calls task(i) for every i in [0, count) and returns when all are done.
+    // `task` must be safe to call concurrently for different indices.
+    void run(size_t count, const std::function<void(size_t)>& task) {
+        unsigned workers = static_cast<unsigned>(std::min<size_t>(threadCount, count));
+        if (workers == 0) return;
+
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        for (unsigned i = 0; i < workers; ++i) queues.push_back(std::make_unique<WorkQueue>());
+        for (size_t i = 0; i < count; ++i) queues[i % workers]->items.push_back(i);
+
+        std::vector<std::thread> threads;
+        for (unsigned id = 0; id < workers; ++id) {
+            threads.emplace_back([&, id] {
+                size_t index;
+                while (takeOwn(*queues[id], index) || steal(queues, id, index)) {
+                    task(index);
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<size_t> items;
+    };
+
+    unsigned threadCount;
+
+    static bool takeOwn(WorkQueue& queue, size_t& index) {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.items.empty()) return false;
+        index = queue.items.back();
+        queue.items.pop_back();
+        return true;
+    }
+
+    static bool steal(std::vector<std::unique_ptr<WorkQueue>>& queues, unsigned thief, size_t& index) {
+        for (size_t offset = 1; offset < queues.size(); ++offset) {
+            WorkQueue& victim = *queues[(thief + offset) % queues.size()];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (victim.items.empty()) continue;
+            index = victim.items.front();
+            victim.items.pop_front();
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif